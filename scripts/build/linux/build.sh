@@ -136,12 +136,14 @@ create_sample_config() {
         "hardcore": false,
         "pvp": true,
         "online_mode": false,
+        "encrypt_connections": false,
         "spawn_protection": 16
     },
     "world": {
         "name": "world",
         "seed": 0,
         "generator": "flat",
+        "generator_deltas": true,
         "spawn_x": 0,
         "spawn_y": 65,
         "spawn_z": 0
@@ -150,10 +152,18 @@ create_sample_config() {
         "io_threads": 4,
         "worker_threads": 0,
         "max_chunks_loaded": 1000,
-        "chunk_unload_timeout": 300000,
+        "chunk_memory_budget_mb": 512,
         "auto_save_interval": 300000,
         "compression_threshold": 256,
-        "network_buffer_size": 8192
+        "chunk_compression_level": 6,
+        "fast_chunk_saves": true,
+        "sync_region_writes": false,
+        "block_log_enabled": true,
+        "block_log_interval_ms": 50,
+        "io_uring": true,
+        "max_open_regions": 256,
+        "network_buffer_size": 8192,
+        "write_batch_bytes": 65536
     },
     "logging": {
         "level": "info",
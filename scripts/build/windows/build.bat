@@ -128,12 +128,14 @@ IF NOT EXIST server.json (
       ECHO     "hardcore": false,
       ECHO     "pvp": true,
       ECHO     "online_mode": false,
+      ECHO     "encrypt_connections": false,
       ECHO     "spawn_protection": 16
       ECHO   },
       ECHO   "world": {
       ECHO     "name": "world",
       ECHO     "seed": 0,
       ECHO     "generator": "flat",
+      ECHO     "generator_deltas": true,
       ECHO     "spawn_x": 0,
       ECHO     "spawn_y": 65,
       ECHO     "spawn_z": 0
@@ -142,10 +144,18 @@ IF NOT EXIST server.json (
       ECHO     "io_threads": 4,
       ECHO     "worker_threads": 0,
       ECHO     "max_chunks_loaded": 1000,
-      ECHO     "chunk_unload_timeout": 300000,
+      ECHO     "chunk_memory_budget_mb": 512,
       ECHO     "auto_save_interval": 300000,
       ECHO     "compression_threshold": 256,
-      ECHO     "network_buffer_size": 8192
+      ECHO     "chunk_compression_level": 6,
+      ECHO     "fast_chunk_saves": true,
+      ECHO     "sync_region_writes": false,
+      ECHO     "block_log_enabled": true,
+      ECHO     "block_log_interval_ms": 50,
+      ECHO     "io_uring": true,
+      ECHO     "max_open_regions": 256,
+      ECHO     "network_buffer_size": 8192,
+      ECHO     "write_batch_bytes": 65536
       ECHO   },
       ECHO   "logging": {
       ECHO     "level": "info",
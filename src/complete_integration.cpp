@@ -85,14 +85,11 @@ void Connection::send_initial_chunks(player::PlayerPtr player) {
             if (dx * dx + dz * dz <= view_distance * view_distance) {
                 world::ChunkPos chunk_pos(player_chunk.x + dx, player_chunk.z + dz);
                 
-                auto chunk = world::g_chunk_manager.get_chunk(chunk_pos);
-                if (!chunk) {
-                    chunk = world::g_chunk_manager.load_chunk(chunk_pos);
-                }
-                
-                if (chunk && chunk->is_loaded()) {
-                    send_chunk_data(chunk);
-                }
+                world::g_chunk_manager.request_chunk(chunk_pos, [self = shared_from_this()](const world::ChunkPtr& chunk) {
+                    if (chunk && chunk->is_loaded() && !self->is_closed()) {
+                        self->send_chunk_data(chunk);
+                    }
+                });
             }
         }
     }
@@ -152,14 +149,11 @@ void Connection::send_chunk_updates(player::PlayerPtr player,
             bool was_loaded = (old_dx * old_dx + old_dz * old_dz <= view_distance * view_distance);
             
             if (!was_loaded) {
-                auto chunk = world::g_chunk_manager.get_chunk(chunk_pos);
-                if (!chunk) {
-                    chunk = world::g_chunk_manager.load_chunk(chunk_pos);
-                }
-                
-                if (chunk && chunk->is_loaded()) {
-                    send_chunk_data(chunk);
-                }
+                world::g_chunk_manager.request_chunk(chunk_pos, [self = shared_from_this()](const world::ChunkPtr& chunk) {
+                    if (chunk && chunk->is_loaded() && !self->is_closed()) {
+                        self->send_chunk_data(chunk);
+                    }
+                });
             }
         }
     }
@@ -225,54 +219,6 @@ PlayerPtr PlayerManager::create_player(network::ConnectionPtr connection, const
 
 }
 
-namespace mc::world {
-
-void ChunkManager::generate_chunk_async(const ChunkPos& pos) {
-    g_thread_pool.submit([this, pos]() {
-        auto chunk = std::make_shared<Chunk>(pos);
-        
-        std::string generator = g_config.get_world_generator();
-        if (generator == "flat") {
-            chunk->generate_flat_world();
-        } else {
-            chunk->generate_flat_world();
-        }
-        
-        {
-            std::lock_guard<std::mutex> lock(chunk_mutex_);
-            loaded_chunks_[pos] = chunk;
-            pending_chunks_.erase(pos);
-        }
-        
-        LOG_DEBUG("Generated chunk at " + std::to_string(pos.x) + ", " + std::to_string(pos.z));
-        
-        cleanup_old_chunks();
-    });
-}
-
-ChunkPtr ChunkManager::load_chunk(const ChunkPos& pos) {
-    {
-        std::lock_guard<std::mutex> lock(chunk_mutex_);
-        
-        auto it = loaded_chunks_.find(pos);
-        if (it != loaded_chunks_.end()) {
-            it->second->touch();
-            return it->second;
-        }
-        
-        if (pending_chunks_.find(pos) != pending_chunks_.end()) {
-            return nullptr;
-        }
-        
-        pending_chunks_.insert(pos);
-    }
-    
-    generate_chunk_async(pos);
-    return nullptr;
-}
-
-}
-
 namespace mc::server {
 
 void MinecraftServer::tick_players() {
@@ -0,0 +1,288 @@
+#pragma once
+
+#include "types.hpp"
+#include "memory_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define MC_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace mc {
+
+struct FileIORequest {
+    int fd = -1;
+    u64 offset = 0;
+    u8* data = nullptr;
+    u32 length = 0;
+    bool write = false;
+    u32 done = 0;
+};
+
+class IoRing {
+public:
+    static constexpr u32 DEPTH = 64;
+
+private:
+#ifdef MC_HAVE_IO_URING
+    int ring_fd_ = -1;
+    void* sq_ring_ = nullptr;
+    void* cq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    u32* sq_tail_ = nullptr;
+    u32* sq_mask_ = nullptr;
+    u32* sq_array_ = nullptr;
+    u32* cq_head_ = nullptr;
+    u32* cq_tail_ = nullptr;
+    u32* cq_mask_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+
+    std::vector<std::pair<void*, size_t>> fixed_buffers_;
+#endif
+    u64 submits_ = 0;
+    u64 operations_ = 0;
+
+#ifdef MC_HAVE_IO_URING
+    template<typename Field>
+    static u32* ring_field(void* ring, Field offset) {
+        return reinterpret_cast<u32*>(static_cast<u8*>(ring) + offset);
+    }
+
+    void register_buffers() {
+        std::vector<iovec> iovecs;
+        for (const auto& [base, size] : g_buffer_pool.arenas()) {
+            iovecs.push_back({base, size});
+        }
+        if (syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, iovecs.data(), iovecs.size()) == 0) {
+            fixed_buffers_ = g_buffer_pool.arenas();
+        }
+    }
+
+    int fixed_index(const FileIORequest& request) const {
+        for (size_t i = 0; i < fixed_buffers_.size(); ++i) {
+            auto* base = static_cast<u8*>(fixed_buffers_[i].first);
+            if (request.data >= base && request.data + request.length <= base + fixed_buffers_[i].second) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    void prepare(FileIORequest& request, u64 user_data) {
+        u32 tail = *sq_tail_;
+        u32 index = tail & *sq_mask_;
+        io_uring_sqe& sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+
+        int buffer = fixed_index(request);
+        if (buffer >= 0) {
+            sqe.opcode = request.write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+            sqe.buf_index = static_cast<u16>(buffer);
+        } else {
+            sqe.opcode = request.write ? IORING_OP_WRITE : IORING_OP_READ;
+        }
+        sqe.fd = request.fd;
+        sqe.off = request.offset + request.done;
+        sqe.addr = reinterpret_cast<u64>(request.data + request.done);
+        sqe.len = request.length - request.done;
+        sqe.user_data = user_data;
+
+        sq_array_[index] = index;
+        std::atomic_ref<u32>(*sq_tail_).store(tail + 1, std::memory_order_release);
+    }
+
+    u32 ready() const {
+        return std::atomic_ref<u32>(*cq_tail_).load(std::memory_order_acquire) - *cq_head_;
+    }
+
+    bool enter(u32 count) {
+        u32 submitted = 0;
+        while (submitted < count) {
+            long result = syscall(__NR_io_uring_enter, ring_fd_, count - submitted, count, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (result < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+                return false;
+            }
+            submits_++;
+            submitted += static_cast<u32>(result);
+        }
+        while (ready() < count) {
+            if (syscall(__NR_io_uring_enter, ring_fd_, 0, count, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void release() {
+        if (ring_fd_ >= 0) ::close(ring_fd_);
+        if (sqes_) munmap(sqes_, sqes_size_);
+        if (cq_ring_ && cq_ring_ != sq_ring_) munmap(cq_ring_, cq_ring_size_);
+        if (sq_ring_) munmap(sq_ring_, sq_ring_size_);
+        sqes_ = nullptr;
+        sq_ring_ = cq_ring_ = nullptr;
+        ring_fd_ = -1;
+    }
+#endif
+
+    static bool run_blocking(FileIORequest& request) {
+#ifndef _WIN32
+        while (request.done < request.length) {
+            ssize_t result = request.write
+                ? ::pwrite(request.fd, request.data + request.done, request.length - request.done, request.offset + request.done)
+                : ::pread(request.fd, request.data + request.done, request.length - request.done, request.offset + request.done);
+            if (result < 0 && errno == EINTR) continue;
+            if (result <= 0) return false;
+            request.done += static_cast<u32>(result);
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+public:
+    IoRing() {
+#ifdef MC_HAVE_IO_URING
+        io_uring_params params{};
+        ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, DEPTH, &params));
+        if (ring_fd_ < 0) return;
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(u32);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+        sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED) {
+            sq_ring_ = nullptr;
+            release();
+            return;
+        }
+        cq_ring_ = single_mmap ? sq_ring_
+            : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            cq_ring_ = nullptr;
+            release();
+            return;
+        }
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            release();
+            return;
+        }
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        sq_tail_ = ring_field(sq_ring_, params.sq_off.tail);
+        sq_mask_ = ring_field(sq_ring_, params.sq_off.ring_mask);
+        sq_array_ = ring_field(sq_ring_, params.sq_off.array);
+        cq_head_ = ring_field(cq_ring_, params.cq_off.head);
+        cq_tail_ = ring_field(cq_ring_, params.cq_off.tail);
+        cq_mask_ = ring_field(cq_ring_, params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(static_cast<u8*>(cq_ring_) + params.cq_off.cqes);
+
+        register_buffers();
+#endif
+    }
+
+    ~IoRing() {
+#ifdef MC_HAVE_IO_URING
+        release();
+#endif
+    }
+
+    IoRing(const IoRing&) = delete;
+    IoRing& operator=(const IoRing&) = delete;
+
+    bool valid() const {
+#ifdef MC_HAVE_IO_URING
+        return ring_fd_ >= 0;
+#else
+        return false;
+#endif
+    }
+
+    bool has_fixed_buffers() const {
+#ifdef MC_HAVE_IO_URING
+        return !fixed_buffers_.empty();
+#else
+        return false;
+#endif
+    }
+
+    // Synchronous: blocks the calling thread until every request has completed. The ring only
+    // batches syscalls (one io_uring_enter per ring-full instead of one pwrite per chunk); it
+    // does not overlap IO with other work. Short transfers are resubmitted, and operations the
+    // kernel rejects are retried with a blocking pread/pwrite.
+    bool submit(FileIORequest* requests, size_t count) {
+        operations_ += count;
+#ifdef MC_HAVE_IO_URING
+        if (valid()) {
+            bool ok = true;
+            std::vector<size_t> queue;
+            queue.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                if (requests[i].done < requests[i].length) queue.push_back(i);
+            }
+
+            while (!queue.empty()) {
+                u32 batch = static_cast<u32>(std::min<size_t>(queue.size(), DEPTH));
+                for (u32 i = 0; i < batch; ++i) {
+                    prepare(requests[queue[i]], queue[i]);
+                }
+                queue.erase(queue.begin(), queue.begin() + batch);
+                if (!enter(batch)) {
+                    release();
+                    break;
+                }
+
+                u32 head = *cq_head_;
+                u32 tail = std::atomic_ref<u32>(*cq_tail_).load(std::memory_order_acquire);
+                for (; head != tail; ++head) {
+                    const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+                    FileIORequest& request = requests[cqe.user_data];
+                    if (cqe.res > 0) {
+                        request.done += static_cast<u32>(cqe.res);
+                        if (request.done < request.length) queue.push_back(cqe.user_data);
+                    } else if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP || cqe.res == -EAGAIN) {
+                        ok &= run_blocking(request);
+                    } else {
+                        ok = false;
+                    }
+                }
+                std::atomic_ref<u32>(*cq_head_).store(head, std::memory_order_release);
+            }
+            if (valid()) return ok;
+        }
+#endif
+        bool ok = true;
+        for (size_t i = 0; i < count; ++i) {
+            ok &= run_blocking(requests[i]);
+        }
+        return ok;
+    }
+
+    u64 submits() const { return submits_; }
+    u64 operations() const { return operations_; }
+};
+
+inline IoRing* thread_io_ring() {
+    thread_local IoRing ring;
+    return ring.valid() ? &ring : nullptr;
+}
+
+}
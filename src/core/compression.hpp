@@ -0,0 +1,116 @@
+#pragma once
+
+#include "types.hpp"
+#include <zlib.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace mc {
+
+enum class CompressionType : u8 {
+    GZIP = 1,
+    ZLIB = 2,
+    NONE = 3
+};
+
+class Deflater {
+private:
+    z_stream stream_{};
+    int level_;
+
+public:
+    explicit Deflater(int level = Z_DEFAULT_COMPRESSION) : level_(level) {
+        if (deflateInit(&stream_, level_) != Z_OK) {
+            throw std::runtime_error("deflateInit failed");
+        }
+    }
+
+    ~Deflater() {
+        deflateEnd(&stream_);
+    }
+
+    Deflater(const Deflater&) = delete;
+    Deflater& operator=(const Deflater&) = delete;
+
+    void set_level(int level) {
+        if (level == level_) return;
+        deflateReset(&stream_);
+        if (deflateParams(&stream_, level, Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::runtime_error("deflateParams failed");
+        }
+        level_ = level;
+    }
+
+    int level() const { return level_; }
+
+    size_t compress(const u8* data, size_t size, std::vector<u8>& out, size_t offset = 0) {
+        deflateReset(&stream_);
+        out.resize(offset + deflateBound(&stream_, static_cast<uLong>(size)));
+        stream_.next_in = const_cast<Bytef*>(data);
+        stream_.avail_in = static_cast<uInt>(size);
+        stream_.next_out = out.data() + offset;
+        stream_.avail_out = static_cast<uInt>(out.size() - offset);
+        if (deflate(&stream_, Z_FINISH) != Z_STREAM_END) {
+            throw std::runtime_error("deflate failed");
+        }
+        out.resize(offset + stream_.total_out);
+        return stream_.total_out;
+    }
+};
+
+class Inflater {
+private:
+    z_stream stream_{};
+
+public:
+    Inflater() {
+        if (inflateInit2(&stream_, 15 + 32) != Z_OK) {
+            throw std::runtime_error("inflateInit failed");
+        }
+    }
+
+    ~Inflater() {
+        inflateEnd(&stream_);
+    }
+
+    Inflater(const Inflater&) = delete;
+    Inflater& operator=(const Inflater&) = delete;
+
+    void decompress(const u8* data, size_t size, std::vector<u8>& out, size_t max_size = 16u << 20) {
+        inflateReset(&stream_);
+        out.resize(std::max<size_t>(size * 4, 4096));
+        stream_.next_in = const_cast<Bytef*>(data);
+        stream_.avail_in = static_cast<uInt>(size);
+        while (true) {
+            stream_.next_out = out.data() + stream_.total_out;
+            stream_.avail_out = static_cast<uInt>(out.size() - stream_.total_out);
+            int result = inflate(&stream_, Z_NO_FLUSH);
+            if (result == Z_STREAM_END) break;
+            if (result != Z_OK && result != Z_BUF_ERROR) {
+                throw std::runtime_error(std::string("inflate failed: ") + (stream_.msg ? stream_.msg : "corrupt data"));
+            }
+            if (stream_.avail_out != 0) {
+                throw std::runtime_error("inflate failed: truncated data");
+            }
+            if (out.size() >= max_size) {
+                throw std::runtime_error("inflate failed: output exceeds limit");
+            }
+            out.resize(std::min(out.size() * 2, max_size));
+        }
+        out.resize(stream_.total_out);
+    }
+};
+
+inline Deflater& thread_deflater() {
+    thread_local Deflater deflater;
+    return deflater;
+}
+
+inline Inflater& thread_inflater() {
+    thread_local Inflater inflater;
+    return inflater;
+}
+
+}
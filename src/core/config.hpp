@@ -39,12 +39,14 @@ public:
                 {"hardcore", false},
                 {"pvp", true},
                 {"online_mode", false},
+                {"encrypt_connections", false},
                 {"spawn_protection", 16}
             }},
             {"world", {
                 {"name", "world"},
                 {"seed", 0},
                 {"generator", "flat"},
+                {"generator_deltas", true},
                 {"spawn_x", 0},
                 {"spawn_y", 65},
                 {"spawn_z", 0}
@@ -53,10 +55,18 @@ public:
                 {"io_threads", 4},
                 {"worker_threads", 0},
                 {"max_chunks_loaded", 1000},
-                {"chunk_unload_timeout", 300000},
+                {"chunk_memory_budget_mb", 512},
                 {"auto_save_interval", 300000},
                 {"compression_threshold", 256},
-                {"network_buffer_size", 8192}
+                {"chunk_compression_level", 6},
+                {"fast_chunk_saves", true},
+                {"sync_region_writes", false},
+                {"block_log_enabled", true},
+                {"block_log_interval_ms", 50},
+                {"io_uring", true},
+                {"max_open_regions", 256},
+                {"network_buffer_size", 8192},
+                {"write_batch_bytes", 65536}
             }},
             {"logging", {
                 {"level", "info"},
@@ -152,11 +162,13 @@ public:
     bool        is_hardcore()           const { return get<bool>("server.hardcore"); }
     bool        is_pvp_enabled()        const { return get<bool>("server.pvp"); }
     bool        is_online_mode()        const { return get<bool>("server.online_mode"); }
+    bool        is_encrypt_connections() const { return get<bool>("server.encrypt_connections", false); }
     i32         get_spawn_protection()  const { return get<i32>("server.spawn_protection"); }
 
     std::string get_world_name()        const { return get<std::string>("world.name"); }
     i64         get_world_seed()        const { return get<i64>("world.seed"); }
     std::string get_world_generator()   const { return get<std::string>("world.generator"); }
+    bool        is_generator_deltas()   const { return get<bool>("world.generator_deltas", true); }
     f64         get_spawn_x()           const { return get<f64>("world.spawn_x"); }
     f64         get_spawn_y()           const { return get<f64>("world.spawn_y"); }
     f64         get_spawn_z()           const { return get<f64>("world.spawn_z"); }
@@ -167,10 +179,18 @@ public:
         return t == 0 ? std::thread::hardware_concurrency() : t;
     }
     size_t      get_max_chunks_loaded() const { return get<size_t>("performance.max_chunks_loaded"); }
-    i64         get_chunk_unload_timeout() const { return get<i64>("performance.chunk_unload_timeout"); }
+    size_t      get_chunk_memory_budget_mb() const { return get<size_t>("performance.chunk_memory_budget_mb", 512); }
     i64         get_auto_save_interval()  const { return get<i64>("performance.auto_save_interval"); }
     i32         get_compression_threshold() const { return get<i32>("performance.compression_threshold"); }
+    i32         get_chunk_compression_level() const { return get<i32>("performance.chunk_compression_level", 6); }
+    bool        is_fast_chunk_saves()   const { return get<bool>("performance.fast_chunk_saves", true); }
+    bool        is_sync_region_writes() const { return get<bool>("performance.sync_region_writes", false); }
+    bool        is_block_log_enabled()  const { return get<bool>("performance.block_log_enabled", true); }
+    i32         get_block_log_interval_ms() const { return get<i32>("performance.block_log_interval_ms", 50); }
+    bool        is_io_uring_enabled()   const { return get<bool>("performance.io_uring", true); }
+    size_t      get_max_open_regions()  const { return get<size_t>("performance.max_open_regions", 256); }
     size_t      get_network_buffer_size()  const { return get<size_t>("performance.network_buffer_size"); }
+    size_t      get_write_batch_bytes()    const { return get<size_t>("performance.write_batch_bytes", 65536); }
 
     std::string get_log_level()         const { return get<std::string>("logging.level"); }
     std::string get_log_file()          const { return get<std::string>("logging.file"); }
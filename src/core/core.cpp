@@ -1,9 +1,11 @@
+#include "epoch.hpp"
 #include "memory_pool.hpp"
 #include "thread_pool.hpp"
 #include "network/packet_types.hpp"
 
 namespace mc {
 
+EpochManager g_epoch_manager;
 BufferPool g_buffer_pool;
 ThreadPool g_thread_pool;
 
@@ -22,7 +24,10 @@ PacketManager::PacketManager() {
     register_packet<status::PingResponsePacket>();
     
     register_packet<login::LoginStartPacket>();
+    register_packet<login::EncryptionRequestPacket>();
+    register_packet<login::EncryptionResponsePacket>();
     register_packet<login::LoginSuccessPacket>();
+    register_packet<login::SetCompressionPacket>();
     
     register_packet<play::KeepAlivePacket>();
     register_packet<play::JoinGamePacket>();
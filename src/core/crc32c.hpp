@@ -0,0 +1,100 @@
+#pragma once
+
+#include "types.hpp"
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MC_HAVE_SSE42_CRC 1
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace mc {
+
+namespace detail {
+
+struct Crc32cTables {
+    std::array<std::array<u32, 256>, 8> table{};
+
+    constexpr Crc32cTables() {
+        for (u32 i = 0; i < 256; ++i) {
+            u32 crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1)));
+            }
+            table[0][i] = crc;
+        }
+        for (u32 i = 0; i < 256; ++i) {
+            for (size_t slice = 1; slice < 8; ++slice) {
+                table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+inline constexpr Crc32cTables crc32c_tables{};
+
+inline u32 crc32c_slice8(u32 crc, const u8* data, size_t size) {
+    const auto& t = crc32c_tables.table;
+    for (; size >= 8; data += 8, size -= 8) {
+        u32 low, high;
+        std::memcpy(&low, data, 4);
+        std::memcpy(&high, data + 4, 4);
+        low ^= crc;
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+    }
+    for (; size > 0; ++data, --size) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *data) & 0xFF];
+    }
+    return crc;
+}
+
+#ifdef MC_HAVE_SSE42_CRC
+#ifndef _MSC_VER
+__attribute__((target("sse4.2")))
+#endif
+inline u32 crc32c_sse42(u32 crc, const u8* data, size_t size) {
+    u64 crc64 = crc;
+    for (; size >= 8; data += 8, size -= 8) {
+        u64 word;
+        std::memcpy(&word, data, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    u32 crc32 = static_cast<u32>(crc64);
+    for (; size > 0; ++data, --size) {
+        crc32 = _mm_crc32_u8(crc32, *data);
+    }
+    return crc32;
+}
+
+inline bool cpu_has_sse42() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#else
+    return __builtin_cpu_supports("sse4.2");
+#endif
+}
+#endif
+
+}
+
+// Slicing-by-8 assumes little-endian loads; it only runs when the CPU lacks SSE4.2.
+inline u32 crc32c(const void* data, size_t size, u32 crc = 0) {
+    const u8* bytes = static_cast<const u8*>(data);
+    crc = ~crc;
+#ifdef MC_HAVE_SSE42_CRC
+    static const bool hardware = detail::cpu_has_sse42();
+    crc = hardware ? detail::crc32c_sse42(crc, bytes, size) : detail::crc32c_slice8(crc, bytes, size);
+#else
+    crc = detail::crc32c_slice8(crc, bytes, size);
+#endif
+    return ~crc;
+}
+
+}
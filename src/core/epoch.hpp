@@ -0,0 +1,178 @@
+#pragma once
+
+#include "types.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mc {
+
+class EpochManager {
+public:
+    static constexpr size_t MAX_READERS = 1024;
+    static constexpr size_t RECLAIM_THRESHOLD = 64;
+
+private:
+    static constexpr u64 IDLE = std::numeric_limits<u64>::max();
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<u64> epoch{IDLE};
+        std::atomic<bool> in_use{false};
+    };
+
+    struct Retired {
+        u64 epoch;
+        void* ptr;
+        void (*deleter)(void*);
+    };
+
+    struct ThreadState {
+        EpochManager* owner = nullptr;
+        ReaderSlot* slot = nullptr;
+        u32 depth = 0;
+
+        ~ThreadState() {
+            if (slot) {
+                slot->epoch.store(IDLE, std::memory_order_release);
+                slot->in_use.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    std::array<ReaderSlot, MAX_READERS> slots_;
+    std::atomic<u64> global_epoch_{1};
+    std::mutex retired_mutex_;
+    std::vector<Retired> retired_;
+
+    ReaderSlot* acquire_slot() {
+        for (auto& slot : slots_) {
+            bool expected = false;
+            if (!slot.in_use.load(std::memory_order_relaxed) &&
+                slot.in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                return &slot;
+            }
+        }
+        throw std::runtime_error("EpochManager: more than " + std::to_string(MAX_READERS) +
+                                 " live threads need epoch reader slots");
+    }
+
+    ThreadState& local_state() {
+        thread_local ThreadState state;
+        if (state.owner != this) {
+            if (state.slot) {
+                state.slot->in_use.store(false, std::memory_order_release);
+                state.slot = nullptr;
+                state.owner = nullptr;
+            }
+            state.slot = acquire_slot();
+            state.owner = this;
+            state.depth = 0;
+        }
+        return state;
+    }
+
+    u64 min_active_epoch() const {
+        u64 result = IDLE;
+        for (const auto& slot : slots_) {
+            u64 epoch = slot.epoch.load(std::memory_order_seq_cst);
+            if (epoch < result) result = epoch;
+        }
+        return result;
+    }
+
+public:
+    EpochManager() = default;
+    EpochManager(const EpochManager&) = delete;
+    EpochManager& operator=(const EpochManager&) = delete;
+
+    ~EpochManager() {
+        for (auto& item : retired_) {
+            item.deleter(item.ptr);
+        }
+    }
+
+    void enter() {
+        ThreadState& state = local_state();
+        if (state.depth++ == 0) {
+            state.slot->epoch.store(global_epoch_.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    void exit() {
+        ThreadState& state = local_state();
+        if (--state.depth == 0) {
+            state.slot->epoch.store(IDLE, std::memory_order_release);
+        }
+    }
+
+    template<typename T>
+    void retire(T* ptr) {
+        if (!ptr) return;
+        u64 epoch = global_epoch_.fetch_add(1, std::memory_order_seq_cst);
+        bool should_reclaim;
+        {
+            std::lock_guard<std::mutex> lock(retired_mutex_);
+            retired_.push_back({epoch, ptr, [](void* p) { delete static_cast<T*>(p); }});
+            should_reclaim = retired_.size() >= RECLAIM_THRESHOLD;
+        }
+        if (should_reclaim) {
+            try_reclaim();
+        }
+    }
+
+    void synchronize() {
+        u64 target = global_epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+        while (min_active_epoch() < target) {
+            std::this_thread::yield();
+        }
+    }
+
+    size_t try_reclaim() {
+        std::vector<Retired> ready;
+        {
+            std::lock_guard<std::mutex> lock(retired_mutex_);
+            u64 safe_before = min_active_epoch();
+            auto split = std::partition(retired_.begin(), retired_.end(),
+                [safe_before](const Retired& item) { return item.epoch >= safe_before; });
+            ready.assign(split, retired_.end());
+            retired_.erase(split, retired_.end());
+        }
+        for (auto& item : ready) {
+            item.deleter(item.ptr);
+        }
+        return ready.size();
+    }
+
+    size_t pending_count() {
+        std::lock_guard<std::mutex> lock(retired_mutex_);
+        return retired_.size();
+    }
+};
+
+extern EpochManager g_epoch_manager;
+
+class EpochGuard {
+private:
+    EpochManager& manager_;
+
+public:
+    explicit EpochGuard(EpochManager& manager = g_epoch_manager) : manager_(manager) {
+        manager_.enter();
+    }
+
+    ~EpochGuard() {
+        manager_.exit();
+    }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+}
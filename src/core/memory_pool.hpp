@@ -59,6 +59,9 @@ public:
     
     size_t allocated_count() const { return allocated_count_.load(); }
     size_t available_count() const { return BlockCount - allocated_count(); }
+    
+    void* arena() const { return memory_.get(); }
+    static constexpr size_t arena_size() { return sizeof(Block) * BlockCount; }
 };
 
 class BufferPool {
@@ -83,6 +86,12 @@ public:
         else if (size <= 16384) large_pool_.deallocate(ptr);
         else std::free(ptr);
     }
+    
+    std::vector<std::pair<void*, size_t>> arenas() const {
+        return {{small_pool_.arena(), small_pool_.arena_size()},
+                {medium_pool_.arena(), medium_pool_.arena_size()},
+                {large_pool_.arena(), large_pool_.arena_size()}};
+    }
 };
 
 extern BufferPool g_buffer_pool;
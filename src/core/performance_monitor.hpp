@@ -19,6 +19,14 @@ private:
     std::atomic<u64> total_memory_used_{0};
     std::atomic<u64> buffer_pool_usage_{0};
     std::atomic<u32> active_connections_{0};
+    std::atomic<u64> region_cache_hits_{0};
+    std::atomic<u64> region_cache_misses_{0};
+    std::atomic<u32> open_region_files_{0};
+    std::atomic<u64> chunk_checksum_failures_{0};
+    std::atomic<u64> raw_bytes_sent_{0};
+    std::atomic<u64> wire_bytes_sent_{0};
+    std::atomic<u64> packets_sent_{0};
+    std::atomic<u64> socket_writes_{0};
     std::atomic<u64> packets_per_second_{0};
     std::atomic<u64> bytes_per_second_{0};
     std::array<f64, 100> tps_history_{};
@@ -132,6 +140,26 @@ public:
         active_connections_.store(count);
     }
 
+    void set_region_cache_stats(u64 hits, u64 misses, u32 open_files) {
+        region_cache_hits_.store(hits);
+        region_cache_misses_.store(misses);
+        open_region_files_.store(open_files);
+    }
+
+    void set_chunk_checksum_failures(u64 failures) {
+        chunk_checksum_failures_.store(failures);
+    }
+
+    void set_network_traffic(u64 raw_bytes_sent, u64 wire_bytes_sent) {
+        raw_bytes_sent_.store(raw_bytes_sent);
+        wire_bytes_sent_.store(wire_bytes_sent);
+    }
+
+    void set_network_writes(u64 packets_sent, u64 socket_writes) {
+        packets_sent_.store(packets_sent);
+        socket_writes_.store(socket_writes);
+    }
+
     f64 get_current_tps() const {
         return current_tps_.load();
     }
@@ -174,6 +202,35 @@ public:
         return bytes_per_second_.load();
     }
 
+    u64 get_region_cache_hits() const {
+        return region_cache_hits_.load();
+    }
+
+    u64 get_region_cache_misses() const {
+        return region_cache_misses_.load();
+    }
+
+    u32 get_open_region_files() const {
+        return open_region_files_.load();
+    }
+
+    u64 get_chunk_checksum_failures() const {
+        return chunk_checksum_failures_.load();
+    }
+
+    u64 get_raw_bytes_sent() const {
+        return raw_bytes_sent_.load();
+    }
+
+    u64 get_wire_bytes_sent() const {
+        return wire_bytes_sent_.load();
+    }
+
+    f64 get_writes_per_packet() const {
+        u64 packets = packets_sent_.load();
+        return packets > 0 ? static_cast<f64>(socket_writes_.load()) / static_cast<f64>(packets) : 0.0;
+    }
+
     f64 get_uptime_seconds() const {
         auto now = std::chrono::steady_clock::now();
         return std::chrono::duration<f64>(now - server_start_time_).count();
@@ -189,6 +246,13 @@ public:
         u64 packets_per_second;
         u64 bytes_per_second;
         f64 uptime_seconds;
+        u64 region_cache_hits;
+        u64 region_cache_misses;
+        u32 open_region_files;
+        u64 chunk_checksum_failures;
+        u64 raw_bytes_sent;
+        u64 wire_bytes_sent;
+        f64 writes_per_packet;
     };
 
     Stats get_stats() const {
@@ -201,7 +265,14 @@ public:
             get_active_connections(),
             get_packets_per_second(),
             get_bytes_per_second(),
-            get_uptime_seconds()
+            get_uptime_seconds(),
+            get_region_cache_hits(),
+            get_region_cache_misses(),
+            get_open_region_files(),
+            get_chunk_checksum_failures(),
+            get_raw_bytes_sent(),
+            get_wire_bytes_sent(),
+            get_writes_per_packet()
         };
     }
 };
@@ -111,14 +111,11 @@ void Connection::send_initial_chunks(player::PlayerPtr player) {
         });
     
     for (const auto& chunk_pos : chunks_to_load) {
-        auto chunk = world::g_chunk_manager.get_chunk(chunk_pos);
-        if (!chunk) {
-            chunk = world::g_chunk_manager.load_chunk(chunk_pos);
-        }
-        
-        if (chunk && chunk->is_loaded()) {
-            send_chunk_data(chunk);
-        }
+        world::g_chunk_manager.request_chunk(chunk_pos, [self = shared_from_this()](const world::ChunkPtr& chunk) {
+            if (chunk && chunk->is_loaded() && !self->is_closed()) {
+                self->send_chunk_data(chunk);
+            }
+        });
     }
 }
 
@@ -155,6 +152,8 @@ void Player::update_loaded_chunks() {
         }
     }
     
+    world::g_chunk_manager.update_viewer(entity_id_, get_chunk_viewer());
+    
     std::lock_guard<std::mutex> lock(chunks_mutex_);
     
     std::vector<world::ChunkPos> to_unload;
@@ -166,6 +165,7 @@ void Player::update_loaded_chunks() {
     
     for (const auto& chunk_pos : to_unload) {
         loaded_chunks_.erase(chunk_pos);
+        world::g_chunk_manager.release_view(chunk_pos);
         
         if (connection_ && !connection_->is_closed()) {
             auto unload_packet = std::make_unique<network::play::UnloadChunkPacket>(
@@ -183,15 +183,13 @@ void Player::update_loaded_chunks() {
     
     for (const auto& chunk_pos : to_load) {
         loaded_chunks_.insert(chunk_pos);
+        world::g_chunk_manager.retain_view(chunk_pos);
         
-        auto chunk = world::g_chunk_manager.get_chunk(chunk_pos);
-        if (!chunk) {
-            chunk = world::g_chunk_manager.load_chunk(chunk_pos);
-        }
-        
-        if (chunk && chunk->is_loaded() && connection_ && !connection_->is_closed()) {
-            connection_->send_chunk_data(chunk);
-        }
+        world::g_chunk_manager.request_chunk(chunk_pos, [connection = connection_](const world::ChunkPtr& chunk) {
+            if (chunk && chunk->is_loaded() && connection && !connection->is_closed()) {
+                connection->send_chunk_data(chunk);
+            }
+        });
     }
 }
 
@@ -200,23 +198,12 @@ void Player::update_loaded_chunks() {
 namespace mc::world {
 
 void Chunk::generate_flat_world() {
-    std::lock_guard<std::mutex> lock(sections_mutex_);
+    constexpr i32 max = CHUNK_SIZE - 1;
     
-    for (i32 x = 0; x < CHUNK_SIZE; ++x) {
-        for (i32 z = 0; z < CHUNK_SIZE; ++z) {
-            set_block(x, WORLD_MIN_Y, z, Block(BEDROCK));
-            
-            for (i32 y = WORLD_MIN_Y + 1; y <= 60; ++y) {
-                set_block(x, y, z, Block(STONE));
-            }
-            
-            for (i32 y = 61; y <= 63; ++y) {
-                set_block(x, y, z, Block(DIRT));
-            }
-            
-            set_block(x, 64, z, Block(GRASS_BLOCK));
-        }
-    }
+    fill(0, WORLD_MIN_Y, 0, max, WORLD_MIN_Y, max, Block(BEDROCK));
+    fill(0, WORLD_MIN_Y + 1, 0, max, 60, max, Block(STONE));
+    fill(0, 61, 0, max, 63, max, Block(DIRT));
+    fill(0, 64, 0, max, 64, max, Block(GRASS_BLOCK));
     
     loaded_.store(true);
     dirty_.store(true);
@@ -224,40 +211,6 @@ void Chunk::generate_flat_world() {
     LOG_DEBUG("Generated flat world chunk at " + std::to_string(position_.x) + ", " + std::to_string(position_.z));
 }
 
-void ChunkManager::cleanup_old_chunks() {
-    if (!auto_unload_enabled_.load()) return;
-    
-    auto now = std::chrono::steady_clock::now();
-    std::vector<ChunkPos> to_unload;
-    
-    {
-        std::lock_guard<std::mutex> lock(chunk_mutex_);
-        
-        if (loaded_chunks_.size() <= max_loaded_chunks_.load()) return;
-        
-        for (const auto& [pos, chunk] : loaded_chunks_) {
-            auto age = std::chrono::duration_cast<std::chrono::milliseconds>(
-                now - chunk->get_last_access()).count();
-            
-            if (age > chunk_timeout_ms_.load()) {
-                to_unload.push_back(pos);
-            }
-        }
-    }
-    
-    size_t unloaded = 0;
-    for (const auto& pos : to_unload) {
-        unload_chunk(pos);
-        unloaded++;
-        
-        if (unloaded >= 10) break;
-    }
-    
-    if (unloaded > 0) {
-        LOG_DEBUG("Unloaded " + std::to_string(unloaded) + " old chunks");
-    }
-}
-
 }
 
 namespace mc::server {
@@ -84,8 +84,14 @@ int main(int argc, char* argv[]) {
                     
                 } else if (command == "gc") {
                     std::cout << "Running garbage collection..." << std::endl;
-                    world::g_chunk_manager.cleanup_old_chunks();
+                    world::g_chunk_manager.enforce_memory_budget();
                     player::g_player_manager.cleanup_offline_players();
+                    u64 compacted = world::g_world_persistence.compact_region_files();
+                    auto storage = world::g_world_persistence.get_storage_stats();
+                    std::cout << "Compacted " << utils::format_bytes(compacted) << " of region data, "
+                              << utils::format_bytes(storage.file_bytes) << " on disk ("
+                              << std::fixed << std::setprecision(1) << storage.fragmentation() * 100.0
+                              << "% free)" << std::endl;
                     std::cout << "Cleanup completed" << std::endl;
                     
                 } else if (command == "save") {
@@ -157,62 +157,6 @@ PlayerPtr PlayerManager::create_player(network::ConnectionPtr connection, const
 
 }
 
-namespace mc::world {
-
-void ChunkManager::generate_chunk_async(const ChunkPos& pos) {
-    g_thread_pool.submit([this, pos]() {
-        auto chunk = std::make_shared<Chunk>(pos);
-        
-        std::string generator = g_config.get_world_generator();
-        if (generator == "flat") {
-            chunk->generate_flat_world();
-        } else {
-            chunk->generate_flat_world();
-        }
-        
-        {
-            std::lock_guard<std::mutex> lock(chunk_mutex_);
-            loaded_chunks_[pos] = chunk;
-            pending_chunks_.erase(pos);
-        }
-        
-        LOG_DEBUG("Generated chunk at " + std::to_string(pos.x) + ", " + std::to_string(pos.z));
-        
-        cleanup_old_chunks();
-    });
-}
-
-ChunkPtr ChunkManager::load_chunk(const ChunkPos& pos) {
-    {
-        std::lock_guard<std::mutex> lock(chunk_mutex_);
-        
-        auto it = loaded_chunks_.find(pos);
-        if (it != loaded_chunks_.end()) {
-            it->second->touch();
-            return it->second;
-        }
-        
-        if (pending_chunks_.find(pos) != pending_chunks_.end()) {
-            return nullptr;
-        }
-        
-        pending_chunks_.insert(pos);
-    }
-    
-    auto saved_chunk = g_world_persistence.load_chunk(pos);
-    if (saved_chunk) {
-        std::lock_guard<std::mutex> lock(chunk_mutex_);
-        loaded_chunks_[pos] = saved_chunk;
-        pending_chunks_.erase(pos);
-        return saved_chunk;
-    }
-    
-    generate_chunk_async(pos);
-    return nullptr;
-}
-
-}
-
 namespace mc::server {
 
 void MinecraftServer::initialize_extensions() {
@@ -271,8 +215,8 @@ void MinecraftServer::tick_world() {
             }
         }
         
-        for (auto& chunk : dirty_chunks) {
-            g_world_persistence.save_chunk_async(chunk);
+        if (!dirty_chunks.empty()) {
+            g_world_persistence.save_chunks_async(dirty_chunks);
         }
     }
 }
@@ -281,17 +225,23 @@ void MinecraftServer::perform_auto_save() {
     LOG_INFO("Performing auto-save...");
     
     auto start_time = std::chrono::steady_clock::now();
+    auto freeze_us = std::make_shared<std::atomic<i64>>(0);
+    
+    auto on_complete = [freeze_us](const world::SnapshotSaveReport& report) {
+        LOG_INFO("Auto-save completed: " + std::to_string(report.saved) + "/" + std::to_string(report.chunks) +
+                " chunks (" + std::to_string(report.bytes / 1024) + " KB) saved in " +
+                std::to_string(static_cast<i64>(report.duration_ms)) + "ms, tick paused " +
+                std::to_string(freeze_us->load()) + "us");
+    };
+    
+    if (g_config.is_block_log_enabled()) {
+        world::g_block_change_log.checkpoint_async(world::g_chunk_manager, g_world_persistence, on_complete);
+    } else {
+        g_world_persistence.save_snapshots_async(world::g_chunk_manager.snapshot_dirty_chunks(), on_complete);
+    }
     
-    g_world_persistence.save_all_chunks();
-    
-    size_t saved_chunks = world::g_chunk_manager.get_loaded_chunk_count();
-    
-    auto end_time = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-        end_time - start_time).count();
-    
-    LOG_INFO("Auto-save completed: " + std::to_string(saved_chunks) + 
-            " chunks saved in " + std::to_string(duration) + "ms");
+    freeze_us->store(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start_time).count());
 }
 
 }
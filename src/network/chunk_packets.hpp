@@ -3,6 +3,8 @@
 #include "packet_types.hpp"
 #include "world/chunk.hpp"
 #include "core/buffer.hpp"
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace mc::network::play {
@@ -54,19 +56,26 @@ public:
         
         Buffer temp_buffer(65536);
         
+        EpochGuard guard;
         auto sections = chunk->get_sections();
         for (size_t i = 0; i < sections.size(); ++i) {
             const auto* section = sections[i];
             
             if (!section || section->is_empty()) {
                 temp_buffer.write_be<i16>(0);
+                serialize_single_value(temp_buffer, world::AIR);
                 continue;
             }
             
-            temp_buffer.write_be<i16>(section->block_count);
+            temp_buffer.write_be<i16>(section->block_count.load(std::memory_order_relaxed));
             
-            serialize_palette(temp_buffer, section);
-            serialize_blocks(temp_buffer, section);
+            auto blocks = section->blocks.snapshot();
+            if (blocks.bits == world::PalettedContainer::SINGLE_VALUE_BITS) {
+                serialize_single_value(temp_buffer, blocks.palette[0]);
+            } else {
+                serialize_palette(temp_buffer, blocks);
+                serialize_blocks(temp_buffer, blocks);
+            }
             serialize_lighting(temp_buffer, section);
         }
         
@@ -77,29 +86,62 @@ public:
     }
     
 private:
-    void serialize_palette(Buffer& buffer, const world::ChunkSection* section) const {
-        buffer.write_byte(15);
+    static constexpr u8 GLOBAL_PALETTE_BITS = 15;
+    
+    void serialize_single_value(Buffer& buffer, world::BlockId id) const {
+        buffer.write_byte(0);
+        buffer.write_varint(id);
         buffer.write_varint(0);
     }
     
-    void serialize_blocks(Buffer& buffer, const world::ChunkSection* section) const {
-        constexpr size_t blocks_per_section = 16 * 16 * 16;
+    void serialize_palette(Buffer& buffer, const world::PalettedContainer::Snapshot& blocks) const {
+        if (blocks.bits == world::PalettedContainer::DIRECT_BITS) {
+            buffer.write_byte(GLOBAL_PALETTE_BITS);
+            return;
+        }
+        buffer.write_byte(blocks.bits);
+        buffer.write_varint(static_cast<i32>(blocks.palette.size()));
+        for (world::BlockId id : blocks.palette) {
+            buffer.write_varint(id);
+        }
+    }
+    
+    void serialize_blocks(Buffer& buffer, const world::PalettedContainer::Snapshot& blocks) const {
+        if (blocks.bits != world::PalettedContainer::DIRECT_BITS) {
+            buffer.write_varint(static_cast<i32>(blocks.data.size()));
+            for (u64 word : blocks.data) {
+                buffer.write_be<u64>(word);
+            }
+            return;
+        }
         
-        buffer.write_varint(static_cast<i32>(blocks_per_section));
+        constexpr i32 source_per_word = 64 / world::PalettedContainer::DIRECT_BITS;
         
-        for (size_t i = 0; i < blocks_per_section; ++i) {
-            i32 y = (i / 256) % 16;
-            i32 z = (i / 16) % 16;
-            i32 x = i % 16;
-            
-            auto block = section->get_block(x, y, z);
-            buffer.write_be<u64>(static_cast<u64>(block.id));
+        constexpr i32 values_per_word = 64 / GLOBAL_PALETTE_BITS;
+        constexpr i32 word_count = (world::PalettedContainer::ENTRY_COUNT + values_per_word - 1) / values_per_word;
+        buffer.write_varint(word_count);
+        for (i32 w = 0; w < word_count; ++w) {
+            u64 word = 0;
+            for (i32 v = 0; v < values_per_word; ++v) {
+                i32 index = w * values_per_word + v;
+                if (index >= world::PalettedContainer::ENTRY_COUNT) break;
+                u64 source = blocks.data[index / source_per_word] >>
+                             ((index % source_per_word) * world::PalettedContainer::DIRECT_BITS);
+                word |= (source & 0x7FFF) << (v * GLOBAL_PALETTE_BITS);
+            }
+            buffer.write_be<u64>(word);
         }
     }
     
     void serialize_lighting(Buffer& buffer, const world::ChunkSection* section) const {
-        buffer.write(section->sky_light, sizeof(section->sky_light));
-        buffer.write(section->block_light, sizeof(section->block_light));
+        serialize_light(buffer, section->sky_light);
+        serialize_light(buffer, section->block_light);
+    }
+    
+    void serialize_light(Buffer& buffer, const world::NibbleArray& light) const {
+        u8 bytes[world::NibbleArray::BYTE_SIZE];
+        light.copy_to(bytes);
+        buffer.write(bytes, sizeof(bytes));
     }
     
     void serialize_biomes(Buffer& buffer) const {
@@ -234,11 +276,12 @@ public:
         u32 block_state;
     };
     
-    world::ChunkPos chunk_pos;
+    ChunkPos chunk_pos;
+    i32 section_y = 0;
     std::vector<BlockChange> changes;
     
     MultiBlockChangePacket() = default;
-    MultiBlockChangePacket(const world::ChunkPos& pos) : chunk_pos(pos) {}
+    MultiBlockChangePacket(const ChunkPos& pos, i32 section = 0) : chunk_pos(pos), section_y(section) {}
     
     i32 get_id() const override { return 0x10; }
     ConnectionState get_state() const override { return ConnectionState::PLAY; }
@@ -246,7 +289,8 @@ public:
     
     void write(Buffer& buffer) const override {
         u64 chunk_coord = static_cast<u64>(chunk_pos.x & 0x3FFFFF) << 42 |
-                         static_cast<u64>(chunk_pos.z & 0x3FFFFF) << 20;
+                         static_cast<u64>(chunk_pos.z & 0x3FFFFF) << 20 |
+                         static_cast<u64>(section_y & 0xFFFFF);
         buffer.write_be<u64>(chunk_coord);
         
         buffer.write_varint(static_cast<i32>(changes.size()));
@@ -264,9 +308,11 @@ public:
         u64 chunk_coord = buffer.read_be<u64>();
         chunk_pos.x = static_cast<i32>(chunk_coord >> 42);
         chunk_pos.z = static_cast<i32>((chunk_coord >> 20) & 0x3FFFFF);
+        section_y = static_cast<i32>(chunk_coord & 0xFFFFF);
         
         if (chunk_pos.x >= 0x200000) chunk_pos.x -= 0x400000;
         if (chunk_pos.z >= 0x200000) chunk_pos.z -= 0x400000;
+        if (section_y >= 0x80000) section_y -= 0x100000;
         
         i32 count = buffer.read_varint();
         changes.resize(count);
@@ -285,4 +331,34 @@ public:
     }
 };
 
+inline std::vector<std::unique_ptr<Packet>> make_block_change_packets(const world::BlockChangeSet& change_set) {
+    std::vector<std::unique_ptr<Packet>> packets;
+    for (const auto& [chunk_pos, chunk_changes] : change_set.chunks()) {
+        if (chunk_changes.resent_sections != 0) {
+            auto chunk = world::g_chunk_manager.get_chunk(chunk_pos);
+            if (!chunk) continue;
+            auto packet = std::make_unique<ChunkDataPacket>(chunk_pos.x, chunk_pos.z);
+            packet->serialize_chunk(chunk);
+            packets.push_back(std::move(packet));
+            continue;
+        }
+        if (chunk_changes.changes.size() == 1) {
+            const auto& change = chunk_changes.changes.front();
+            packets.push_back(std::make_unique<BlockChangePacket>(change.position, change.block.id));
+            continue;
+        }
+        std::unordered_map<i32, std::unique_ptr<MultiBlockChangePacket>> by_section;
+        for (const auto& change : chunk_changes.changes) {
+            i32 section_y = change.position.y >> 4;
+            auto& packet = by_section[section_y];
+            if (!packet) packet = std::make_unique<MultiBlockChangePacket>(chunk_pos, section_y);
+            packet->add_change(change.position, change.block.id);
+        }
+        for (auto& [section_y, packet] : by_section) {
+            packets.push_back(std::move(packet));
+        }
+    }
+    return packets;
+}
+
 }
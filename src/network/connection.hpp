@@ -1,11 +1,13 @@
 #pragma once
+#include "frame_decoder.hpp"
 #include "packet_types.hpp"
+#include "protocol_cipher.hpp"
 #include "core/buffer.hpp"
+#include "core/compression.hpp"
 #include "core/thread_pool.hpp"
 #include <asio.hpp>
 #include <memory>
 #include <atomic>
-#include <queue>
 #include <mutex>
 #include <chrono>
 #include <thread>
@@ -16,25 +18,67 @@ namespace mc::network {
 using tcp = asio::ip::tcp;
 using ConnectionPtr = std::shared_ptr<class Connection>;
 
+struct TrafficStats {
+    u64 raw_bytes_sent = 0;
+    u64 wire_bytes_sent = 0;
+    u64 raw_bytes_received = 0;
+    u64 wire_bytes_received = 0;
+    u64 packets_sent = 0;
+    u64 socket_writes = 0;
+};
+
+// An encoded frame shared by every recipient of a broadcast; never modified once built.
+using SharedFrame = std::shared_ptr<const Buffer>;
+
 class Connection : public std::enable_shared_from_this<Connection> {
 private:
     tcp::socket socket_;
     ConnectionState state_;
-    Buffer read_buffer_;
+    FrameDecoder decoder_;
     Buffer write_buffer_;
-    std::queue<Buffer> write_queue_;
+    struct OutboundFrame {
+        SharedFrame shared;
+        Buffer owned;
+
+        const byte* data() const { return shared ? shared->data() : owned.data(); }
+        size_t size() const { return shared ? shared->size() : owned.size(); }
+    };
+
+    std::vector<OutboundFrame> pending_writes_;
+    std::vector<OutboundFrame> inflight_writes_;
+    size_t pending_bytes_ = 0;
+    size_t write_batch_bytes_ = 0;
+    bool writing_ = false;
+    bool flush_requested_ = false;
     std::mutex write_mutex_;
-    std::atomic<bool> writing_{false};
     std::atomic<bool> closed_{false};
     std::atomic<i64> last_ping_time_{0};
     std::atomic<i64> last_keep_alive_{0};
-    bool compression_enabled_{false};
-    i32 compression_threshold_{-1};
+    i32 login_compression_threshold_{-1};
+    std::shared_ptr<const ServerKeyPair> key_pair_;
+    std::vector<byte> verify_token_;
+    std::unique_ptr<CipherStream> encryptor_;
+    std::unique_ptr<CipherStream> decryptor_;
+    std::atomic<i32> compression_threshold_{-1};
+    std::atomic<u64> raw_bytes_sent_{0};
+    std::atomic<u64> wire_bytes_sent_{0};
+    std::atomic<u64> raw_bytes_received_{0};
+    std::atomic<u64> wire_bytes_received_{0};
+    std::atomic<u64> packets_sent_{0};
+    std::atomic<u64> socket_writes_{0};
     GameProfile profile_;
     std::atomic<u32> entity_id_{0};
     Location location_;
     std::mutex location_mutex_;
-    std::vector<byte> temp_read_buf_;
+
+    static constexpr i32 MAX_UNCOMPRESSED_PACKET = 8 << 20;
+    // Nothing a client sends before Login Success comes close to this, so an unauthenticated peer
+    // cannot make the decoder buffer more.
+    static constexpr size_t MAX_LOGIN_FRAME = 32 * 1024;
+    // Small frames are appended to the previous pending buffer so one flush stays within the
+    // iovec count a single gathered write can take.
+    static constexpr size_t COALESCE_FRAME_BYTES = 512;
+    static constexpr size_t COALESCE_BUFFER_BYTES = 16 * 1024;
 
     static size_t get_varint_size(i32 value) {
         u32 uvalue = static_cast<u32>(value);
@@ -48,9 +92,9 @@ private:
 
     void start_read() {
         if (closed_.load()) return;
-        if (temp_read_buf_.empty()) temp_read_buf_.resize(8192);
+        auto [data, size] = decoder_.writable();
         auto self = shared_from_this();
-        socket_.async_read_some(asio::buffer(temp_read_buf_.data(), temp_read_buf_.size()),
+        socket_.async_read_some(asio::buffer(data, size),
             [self](std::error_code ec, std::size_t bytes_transferred) {
                 if (!ec && bytes_transferred > 0) {
                     self->handle_read(bytes_transferred);
@@ -61,25 +105,62 @@ private:
     }
 
     void handle_read(std::size_t bytes_transferred) {
-        read_buffer_.write(temp_read_buf_.data(), bytes_transferred);
-        while (read_buffer_.readable() > 0) {
-            size_t initial_pos = read_buffer_.size();
+        byte* received = decoder_.commit(bytes_transferred);
+        if (decryptor_) decryptor_->update(received, bytes_transferred);
+        
+        FrameSlice frame;
+        FrameDecoder::Result result;
+        while ((result = decoder_.next(frame)) == FrameDecoder::Result::FRAME) {
             try {
-                i32 packet_length = read_buffer_.read_varint();
-                if (read_buffer_.readable() < static_cast<size_t>(packet_length)) {
-                    break;
-                }
-                Buffer packet_data(read_buffer_.data() + initial_pos, packet_length);
+                Buffer packet_data(frame.data, frame.size);
                 process_packet(packet_data);
             } catch (...) {
                 close();
                 return;
             }
+            if (closed_.load()) return;
+        }
+        if (result == FrameDecoder::Result::MALFORMED) {
+            close();
+            return;
         }
         start_read();
     }
 
-    void process_packet(Buffer& packet_buffer) {
+    // With compression on, a frame is VarInt data length (0 if sent uncompressed) followed by the
+    // zlib stream of packet id + payload.
+    void process_packet(Buffer& frame) {
+        wire_bytes_received_.fetch_add(frame.size(), std::memory_order_relaxed);
+        i32 threshold = compression_threshold_.load(std::memory_order_acquire);
+        if (threshold < 0) {
+            raw_bytes_received_.fetch_add(frame.size(), std::memory_order_relaxed);
+            dispatch_packet(frame);
+            return;
+        }
+        
+        i32 data_length = frame.read_varint();
+        const byte* data = frame.data() + (frame.size() - frame.readable());
+        if (data_length == 0) {
+            Buffer packet_buffer(data, frame.readable());
+            raw_bytes_received_.fetch_add(packet_buffer.size(), std::memory_order_relaxed);
+            dispatch_packet(packet_buffer);
+            return;
+        }
+        if (data_length < threshold || data_length > MAX_UNCOMPRESSED_PACKET) {
+            throw std::runtime_error("Bad compressed packet length " + std::to_string(data_length));
+        }
+        
+        thread_local std::vector<u8> inflated;
+        thread_inflater().decompress(data, frame.readable(), inflated, static_cast<size_t>(data_length));
+        if (inflated.size() != static_cast<size_t>(data_length)) {
+            throw std::runtime_error("Compressed packet length mismatch");
+        }
+        Buffer packet_buffer(inflated.data(), inflated.size());
+        raw_bytes_received_.fetch_add(packet_buffer.size(), std::memory_order_relaxed);
+        dispatch_packet(packet_buffer);
+    }
+
+    void dispatch_packet(Buffer& packet_buffer) {
         i32 packet_id = packet_buffer.read_varint();
         auto packet = g_packet_manager.create_packet(state_, PacketDirection::SERVERBOUND, packet_id);
         if (!packet) return;
@@ -121,12 +202,49 @@ private:
             profile_.username = ls->username;
             profile_.display_name = ls->username;
             profile_.uuid = ls->player_uuid;
-            send_packet(std::make_unique<login::LoginSuccessPacket>(profile_.uuid, profile_.username));
-            state_ = ConnectionState::PLAY;
-            g_thread_pool.submit([self = shared_from_this()]() {
-                self->initialize_play_state();
-            });
+            if (key_pair_) {
+                verify_token_.resize(4);
+                RAND_bytes(verify_token_.data(), static_cast<int>(verify_token_.size()));
+                send_packet(std::make_unique<login::EncryptionRequestPacket>(key_pair_->public_key(), verify_token_));
+                return;
+            }
+            finish_login();
+        } else if (auto* er = dynamic_cast<login::EncryptionResponsePacket*>(p)) {
+            if (!key_pair_ || verify_token_.empty() || decryptor_) {
+                close();
+                return;
+            }
+            std::vector<byte> secret = key_pair_->decrypt(er->shared_secret);
+            if (secret.size() != CipherStream::KEY_SIZE || key_pair_->decrypt(er->verify_token) != verify_token_) {
+                close();
+                return;
+            }
+            enable_encryption(secret.data());
+            finish_login();
+        }
+    }
+
+    void finish_login() {
+        if (login_compression_threshold_ >= 0) {
+            send_packet(std::make_unique<login::SetCompressionPacket>(login_compression_threshold_));
+            compression_threshold_.store(login_compression_threshold_, std::memory_order_release);
         }
+        send_packet(std::make_unique<login::LoginSuccessPacket>(profile_.uuid, profile_.username));
+        state_ = ConnectionState::PLAY;
+        decoder_.set_max_frame(FrameDecoder::MAX_FRAME);
+        g_thread_pool.submit([self = shared_from_this()]() {
+            self->initialize_play_state();
+        });
+    }
+
+    // Anything already buffered after the Encryption Response was sent encrypted by the client.
+    void enable_encryption(const u8* secret) {
+        {
+            std::lock_guard<std::mutex> lg(write_mutex_);
+            encryptor_ = std::make_unique<CipherStream>(secret, true);
+        }
+        decryptor_ = std::make_unique<CipherStream>(secret, false);
+        decoder_.for_each_unread([this](byte* data, size_t size) { decryptor_->update(data, size); });
     }
 
     void handle_play_packet(Packet* p) {
@@ -169,38 +287,88 @@ private:
         });
     }
 
+    bool append_to_tail(const byte* data, size_t size) {
+        if (size > COALESCE_FRAME_BYTES || pending_writes_.empty()) return false;
+        OutboundFrame& tail = pending_writes_.back();
+        if (tail.shared || tail.owned.size() + size > COALESCE_BUFFER_BYTES) return false;
+        tail.owned.write(data, size);
+        return true;
+    }
+
+    void queue_frame(Buffer&& frame) {
+        pending_bytes_ += frame.size();
+        if (append_to_tail(frame.data(), frame.size())) return;
+        pending_writes_.push_back({nullptr, std::move(frame)});
+    }
+
+    // Small shared frames are cheaper to copy into the tail than to give their own iovec.
+    void queue_frame(const SharedFrame& frame) {
+        pending_bytes_ += frame->size();
+        if (append_to_tail(frame->data(), frame->size())) return;
+        if (frame->size() <= COALESCE_FRAME_BYTES) {
+            Buffer copy(COALESCE_FRAME_BYTES);
+            copy.write(frame->data(), frame->size());
+            pending_writes_.push_back({nullptr, std::move(copy)});
+        } else {
+            pending_writes_.push_back({frame, Buffer()});
+        }
+    }
+
+    // Outside PLAY every packet is latency-bound (status pings, the login exchange), so only play
+    // traffic waits for the end-of-tick flush.
+    bool should_flush() const {
+        return write_batch_bytes_ == 0 || state_ != ConnectionState::PLAY || pending_bytes_ >= write_batch_bytes_;
+    }
+
     void start_write() {
-        if (writing_.exchange(true)) return;
-        std::lock_guard<std::mutex> lg(write_mutex_);
-        if (write_queue_.empty()) {
-            writing_.store(false);
-            return;
+        std::vector<asio::const_buffer> sequence;
+        {
+            std::lock_guard<std::mutex> lg(write_mutex_);
+            if (pending_writes_.empty()) return;
+            if (writing_) {
+                flush_requested_ = true;
+                return;
+            }
+            writing_ = true;
+            flush_requested_ = false;
+            inflight_writes_.swap(pending_writes_);
+            pending_bytes_ = 0;
+            sequence.reserve(inflight_writes_.size());
+            for (const OutboundFrame& frame : inflight_writes_) {
+                sequence.emplace_back(frame.data(), frame.size());
+            }
         }
-        Buffer& buf = write_queue_.front();
         auto self = shared_from_this();
-        asio::async_write(socket_, asio::buffer(buf.data(), buf.size()),
+        asio::async_write(socket_, sequence,
+            [self](const std::error_code& ec, std::size_t transferred) -> std::size_t {
+                // Consulted before each write_some, so every non-zero answer is one more syscall.
+                std::size_t next = asio::transfer_all()(ec, transferred);
+                if (next > 0) self->socket_writes_.fetch_add(1, std::memory_order_relaxed);
+                return next;
+            },
             [self](std::error_code ec, std::size_t) {
                 self->handle_write(ec);
             });
     }
 
     void handle_write(std::error_code ec) {
+        bool more;
         {
             std::lock_guard<std::mutex> lg(write_mutex_);
-            if (!write_queue_.empty()) write_queue_.pop();
+            inflight_writes_.clear();
+            writing_ = false;
+            more = !pending_writes_.empty() && (flush_requested_ || should_flush());
         }
         if (ec) { close(); return; }
-        writing_.store(false);
-        start_write();
+        if (more) start_write();
     }
 
 public:
     explicit Connection(tcp::socket&& s)
         : socket_(std::move(s))
         , state_(ConnectionState::HANDSHAKING)
-        , read_buffer_(8192)
-        , write_buffer_(8192)
-        , temp_read_buf_() {
+        , write_buffer_(8192) {
+        decoder_.set_max_frame(MAX_LOGIN_FRAME);
         socket_.set_option(tcp::no_delay(true));
         socket_.set_option(asio::socket_base::keep_alive(true));
     }
@@ -209,21 +377,94 @@ public:
 
     void start() { start_read(); }
 
+    // Applies during login, before Set Compression is sent; -1 leaves the connection uncompressed.
+    void set_compression_threshold(i32 threshold) {
+        login_compression_threshold_ = threshold;
+    }
+
+    // With a key pair, login performs the encryption handshake before Login Success.
+    void set_key_pair(std::shared_ptr<const ServerKeyPair> key_pair) {
+        key_pair_ = std::move(key_pair);
+    }
+
+    // Bytes of play traffic that may wait for flush(); 0 writes every packet as it is sent.
+    void set_write_batch_bytes(size_t bytes) {
+        std::lock_guard<std::mutex> lg(write_mutex_);
+        write_batch_bytes_ = bytes;
+    }
+
+    // Frames are encrypted as they are queued, so the cipher stream follows queue order.
     void send_packet(std::unique_ptr<Packet> p) {
         if (closed_.load()) return;
-        Buffer tmp(1024);
-        p->write(tmp);
-        Buffer fin(tmp.size() + 16);
-        fin.write_varint(static_cast<i32>(tmp.size()) + static_cast<i32>(get_varint_size(p->get_id())));
-        fin.write_varint(p->get_id());
-        fin.write(tmp.data(), tmp.size());
+        Buffer body(1024);
+        body.write_varint(p->get_id());
+        p->write(body);
+        Buffer fin = encode_frame(body, compression_threshold_.load(std::memory_order_acquire));
+        raw_bytes_sent_.fetch_add(body.size(), std::memory_order_relaxed);
+        wire_bytes_sent_.fetch_add(fin.size(), std::memory_order_relaxed);
+        bool flush_now;
+        {
+            std::lock_guard<std::mutex> lg(write_mutex_);
+            if (encryptor_) encryptor_->update(fin.data(), fin.size());
+            queue_frame(std::move(fin));
+            flush_now = should_flush();
+        }
+        packets_sent_.fetch_add(1, std::memory_order_relaxed);
+        if (flush_now) start_write();
+    }
+
+    // Queues a frame built by encode_frame() with this connection's compression threshold.
+    // raw_size is the size of the uncompressed body, for traffic stats.
+    void send_frame(const SharedFrame& frame, size_t raw_size) {
+        if (closed_.load()) return;
+        raw_bytes_sent_.fetch_add(raw_size, std::memory_order_relaxed);
+        wire_bytes_sent_.fetch_add(frame->size(), std::memory_order_relaxed);
+        bool flush_now;
         {
             std::lock_guard<std::mutex> lg(write_mutex_);
-            write_queue_.push(std::move(fin));
+            if (encryptor_) {
+                Buffer copy(frame->size());
+                copy.write(frame->data(), frame->size());
+                encryptor_->update(copy.data(), copy.size());
+                queue_frame(std::move(copy));
+            } else {
+                queue_frame(frame);
+            }
+            flush_now = should_flush();
         }
+        packets_sent_.fetch_add(1, std::memory_order_relaxed);
+        if (flush_now) start_write();
+    }
+
+    // Writes everything queued so far with one gathered write; called at the end of each tick.
+    void flush() {
+        if (closed_.load()) return;
         start_write();
     }
 
+    // body is the packet id followed by its fields; a negative threshold means no compression.
+    static Buffer encode_frame(const Buffer& body, i32 threshold) {
+        i32 body_size = static_cast<i32>(body.size());
+        Buffer fin(body.size() + 16);
+        if (threshold < 0) {
+            fin.write_varint(body_size);
+            fin.write(body.data(), body.size());
+        } else if (body_size < threshold) {
+            fin.write_varint(body_size + 1);
+            fin.write_varint(0);
+            fin.write(body.data(), body.size());
+        } else {
+            thread_local std::vector<u8> deflated;
+            Deflater& deflater = thread_deflater();
+            deflater.set_level(Z_DEFAULT_COMPRESSION);
+            deflater.compress(body.data(), body.size(), deflated);
+            fin.write_varint(static_cast<i32>(get_varint_size(body_size) + deflated.size()));
+            fin.write_varint(body_size);
+            fin.write(deflated.data(), deflated.size());
+        }
+        return fin;
+    }
+
     void close() {
         if (closed_.exchange(true)) return;
         std::error_code ec;
@@ -234,6 +475,14 @@ public:
     ConnectionState get_state() const { return state_; }
     const GameProfile& get_profile() const { return profile_; }
     u32 get_entity_id() const { return entity_id_.load(); }
+    bool is_compression_enabled() const { return compression_threshold_.load() >= 0; }
+    i32 get_compression_threshold() const { return compression_threshold_.load(std::memory_order_acquire); }
+    bool is_encrypted() const { return decryptor_ != nullptr; }
+    TrafficStats get_traffic_stats() const {
+        return {raw_bytes_sent_.load(std::memory_order_relaxed), wire_bytes_sent_.load(std::memory_order_relaxed),
+                raw_bytes_received_.load(std::memory_order_relaxed), wire_bytes_received_.load(std::memory_order_relaxed),
+                packets_sent_.load(std::memory_order_relaxed), socket_writes_.load(std::memory_order_relaxed)};
+    }
     Location get_location() const {
         std::lock_guard<std::mutex> lg(location_mutex_);
         return location_;
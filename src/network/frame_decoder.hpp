@@ -0,0 +1,132 @@
+#pragma once
+#include "core/types.hpp"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace mc::network {
+
+struct FrameSlice {
+    const byte* data = nullptr;
+    size_t size = 0;
+};
+
+// Socket reads land directly in a power-of-two ring and complete frames are handed out as slices
+// into it. Only a frame that wraps past the end of the ring is copied, into a scratch buffer. The
+// ring grows only as bytes actually arrive and returns to its default size once drained.
+class FrameDecoder {
+public:
+    enum class Result {
+        FRAME,
+        NEED_MORE,
+        MALFORMED
+    };
+
+    static constexpr size_t MAX_LENGTH_BYTES = 3;
+    static constexpr size_t MAX_FRAME = (size_t(1) << (7 * MAX_LENGTH_BYTES)) - 1;
+
+private:
+    std::vector<byte> ring_;
+    std::vector<byte> scratch_;
+    u64 read_ = 0;
+    u64 write_ = 0;
+    size_t default_capacity_;
+    size_t max_frame_ = MAX_FRAME;
+
+    size_t mask() const { return ring_.size() - 1; }
+    byte at(u64 index) const { return ring_[index & mask()]; }
+
+    void reallocate(size_t capacity) {
+        std::vector<byte> ring(capacity);
+        size_t unread = static_cast<size_t>(write_ - read_);
+        copy_out(read_, ring.data(), unread);
+        ring_.swap(ring);
+        read_ = 0;
+        write_ = unread;
+    }
+
+    void copy_out(u64 from, byte* out, size_t size) const {
+        size_t offset = from & mask();
+        size_t first = std::min(size, ring_.size() - offset);
+        std::memcpy(out, ring_.data() + offset, first);
+        std::memcpy(out + first, ring_.data(), size - first);
+    }
+
+public:
+    explicit FrameDecoder(size_t capacity = 64 * 1024) {
+        size_t size = 16;
+        while (size < capacity) size *= 2;
+        ring_.resize(size);
+        default_capacity_ = size;
+    }
+
+    // Frames declaring a longer body are rejected as malformed before any of it is buffered.
+    void set_max_frame(size_t max_frame) { max_frame_ = std::min(max_frame, MAX_FRAME); }
+
+    size_t buffered() const { return static_cast<size_t>(write_ - read_); }
+    size_t capacity() const { return ring_.size(); }
+
+    // Contiguous free space for the next socket read; never empty.
+    std::pair<byte*, size_t> writable() {
+        if (read_ == write_) read_ = write_ = 0;
+        if (ring_.size() > default_capacity_ && buffered() < default_capacity_) {
+            reallocate(default_capacity_);
+        } else if (buffered() == ring_.size()) {
+            reallocate(ring_.size() * 2);
+        }
+        size_t offset = write_ & mask();
+        size_t free = ring_.size() - buffered();
+        return {ring_.data() + offset, std::min(free, ring_.size() - offset)};
+    }
+
+    // Marks bytes written into the span from writable() as received and returns their start.
+    byte* commit(size_t size) {
+        byte* start = ring_.data() + (write_ & mask());
+        write_ += size;
+        return start;
+    }
+
+    // The slice stays valid until the next call to next() or writable().
+    Result next(FrameSlice& frame) {
+        u64 available = write_ - read_;
+        u32 length = 0;
+        size_t prefix = 0;
+        while (true) {
+            if (prefix == available) return Result::NEED_MORE;
+            byte b = at(read_ + prefix);
+            length |= static_cast<u32>(b & 0x7F) << (7 * prefix);
+            prefix++;
+            if (!(b & 0x80)) break;
+            if (prefix == MAX_LENGTH_BYTES) return Result::MALFORMED;
+        }
+        if (length == 0 || length > max_frame_) return Result::MALFORMED;
+        if (available < prefix + length) return Result::NEED_MORE;
+
+        u64 start = read_ + prefix;
+        size_t offset = start & mask();
+        if (offset + length <= ring_.size()) {
+            frame.data = ring_.data() + offset;
+        } else {
+            scratch_.resize(length);
+            copy_out(start, scratch_.data(), length);
+            frame.data = scratch_.data();
+        }
+        frame.size = length;
+        read_ = start + length;
+        return Result::FRAME;
+    }
+
+    // Runs fn over the unread bytes in place, as at most two contiguous spans.
+    template<typename Fn>
+    void for_each_unread(Fn&& fn) {
+        size_t unread = buffered();
+        if (unread == 0) return;
+        size_t offset = read_ & mask();
+        size_t first = std::min(unread, ring_.size() - offset);
+        fn(ring_.data() + offset, first);
+        if (unread > first) fn(ring_.data(), unread - first);
+    }
+};
+
+}
@@ -12,7 +12,10 @@ PacketManager::PacketManager() {
     register_packet<status::PingResponsePacket>();
     
     register_packet<login::LoginStartPacket>();
+    register_packet<login::EncryptionRequestPacket>();
+    register_packet<login::EncryptionResponsePacket>();
     register_packet<login::LoginSuccessPacket>();
+    register_packet<login::SetCompressionPacket>();
     
     register_packet<play::KeepAlivePacket>();
     register_packet<play::JoinGamePacket>();
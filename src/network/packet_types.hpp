@@ -131,6 +131,15 @@ public:
 
 namespace login {
 
+inline void read_byte_array(Buffer& buffer, std::vector<byte>& out) {
+    i32 length = buffer.read_varint();
+    if (length < 0 || static_cast<size_t>(length) > buffer.readable() || length > 1024) {
+        throw std::runtime_error("Invalid byte array length");
+    }
+    out.resize(static_cast<size_t>(length));
+    buffer.read(out.data(), out.size());
+}
+
 class LoginStartPacket : public Packet {
 public:
     std::string username;
@@ -150,6 +159,51 @@ public:
     }
 };
 
+class EncryptionRequestPacket : public Packet {
+public:
+    std::string server_id;
+    std::vector<byte> public_key;
+    std::vector<byte> verify_token;
+    EncryptionRequestPacket() = default;
+    EncryptionRequestPacket(const std::vector<byte>& key, const std::vector<byte>& token)
+        : public_key(key), verify_token(token) {}
+    i32 get_id() const override { return 0x01; }
+    ConnectionState get_state() const override { return ConnectionState::LOGIN; }
+    PacketDirection get_direction() const override { return PacketDirection::CLIENTBOUND; }
+    void write(Buffer& buffer) const override {
+        buffer.write_string(server_id);
+        buffer.write_varint(static_cast<i32>(public_key.size()));
+        buffer.write(public_key.data(), public_key.size());
+        buffer.write_varint(static_cast<i32>(verify_token.size()));
+        buffer.write(verify_token.data(), verify_token.size());
+    }
+    void read(Buffer& buffer) override {
+        server_id = buffer.read_string();
+        read_byte_array(buffer, public_key);
+        read_byte_array(buffer, verify_token);
+    }
+};
+
+class EncryptionResponsePacket : public Packet {
+public:
+    std::vector<byte> shared_secret;
+    std::vector<byte> verify_token;
+    EncryptionResponsePacket() = default;
+    i32 get_id() const override { return 0x01; }
+    ConnectionState get_state() const override { return ConnectionState::LOGIN; }
+    PacketDirection get_direction() const override { return PacketDirection::SERVERBOUND; }
+    void write(Buffer& buffer) const override {
+        buffer.write_varint(static_cast<i32>(shared_secret.size()));
+        buffer.write(shared_secret.data(), shared_secret.size());
+        buffer.write_varint(static_cast<i32>(verify_token.size()));
+        buffer.write(verify_token.data(), verify_token.size());
+    }
+    void read(Buffer& buffer) override {
+        read_byte_array(buffer, shared_secret);
+        read_byte_array(buffer, verify_token);
+    }
+};
+
 class LoginSuccessPacket : public Packet {
 public:
     UUID player_uuid;
@@ -171,6 +225,22 @@ public:
     }
 };
 
+class SetCompressionPacket : public Packet {
+public:
+    i32 threshold;
+    SetCompressionPacket() : threshold(-1) {}
+    explicit SetCompressionPacket(i32 threshold) : threshold(threshold) {}
+    i32 get_id() const override { return 0x03; }
+    ConnectionState get_state() const override { return ConnectionState::LOGIN; }
+    PacketDirection get_direction() const override { return PacketDirection::CLIENTBOUND; }
+    void write(Buffer& buffer) const override {
+        buffer.write_varint(threshold);
+    }
+    void read(Buffer& buffer) override {
+        threshold = buffer.read_varint();
+    }
+};
+
 }
 
 namespace play {
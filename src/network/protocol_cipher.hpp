@@ -0,0 +1,100 @@
+#pragma once
+#include "core/types.hpp"
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include <vector>
+
+namespace mc::network {
+
+// AES-128-CFB8 keyed and IV'd with the shared secret, as the protocol requires. One context per
+// direction lives for the whole connection; EVP picks AES-NI when the CPU has it.
+class CipherStream {
+private:
+    EVP_CIPHER_CTX* ctx_;
+
+public:
+    static constexpr size_t KEY_SIZE = 16;
+
+    CipherStream(const u8* key, bool encrypt) : ctx_(EVP_CIPHER_CTX_new()) {
+        if (!ctx_ || EVP_CipherInit_ex(ctx_, EVP_aes_128_cfb8(), nullptr, key, key, encrypt ? 1 : 0) != 1) {
+            EVP_CIPHER_CTX_free(ctx_);
+            throw std::runtime_error("Failed to initialise AES-CFB8 cipher");
+        }
+    }
+
+    ~CipherStream() {
+        EVP_CIPHER_CTX_free(ctx_);
+    }
+
+    CipherStream(const CipherStream&) = delete;
+    CipherStream& operator=(const CipherStream&) = delete;
+
+    void update(u8* data, size_t size) {
+        while (size > 0) {
+            int chunk = static_cast<int>(std::min<size_t>(size, INT_MAX));
+            int written = 0;
+            if (EVP_CipherUpdate(ctx_, data, &written, data, chunk) != 1 || written != chunk) {
+                throw std::runtime_error("AES-CFB8 update failed");
+            }
+            data += chunk;
+            size -= static_cast<size_t>(chunk);
+        }
+    }
+};
+
+class ServerKeyPair {
+private:
+    EVP_PKEY* key_ = nullptr;
+    std::vector<u8> public_key_;
+
+public:
+    ServerKeyPair() {
+        EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, nullptr);
+        bool ok = ctx && EVP_PKEY_keygen_init(ctx) == 1 &&
+                  EVP_PKEY_CTX_set_rsa_keygen_bits(ctx, 1024) == 1 &&
+                  EVP_PKEY_keygen(ctx, &key_) == 1;
+        EVP_PKEY_CTX_free(ctx);
+        if (!ok) throw std::runtime_error("Failed to generate server key pair");
+
+        int length = i2d_PUBKEY(key_, nullptr);
+        public_key_.resize(static_cast<size_t>(std::max(length, 0)));
+        u8* out = public_key_.data();
+        if (length <= 0 || i2d_PUBKEY(key_, &out) != length) {
+            EVP_PKEY_free(key_);
+            throw std::runtime_error("Failed to encode server public key");
+        }
+    }
+
+    ~ServerKeyPair() {
+        EVP_PKEY_free(key_);
+    }
+
+    ServerKeyPair(const ServerKeyPair&) = delete;
+    ServerKeyPair& operator=(const ServerKeyPair&) = delete;
+
+    const std::vector<u8>& public_key() const { return public_key_; }
+
+    std::vector<u8> decrypt(const std::vector<u8>& data) const {
+        EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(key_, nullptr);
+        std::vector<u8> out;
+        size_t length = 0;
+        bool ok = ctx && EVP_PKEY_decrypt_init(ctx) == 1 &&
+                  EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING) == 1 &&
+                  EVP_PKEY_decrypt(ctx, nullptr, &length, data.data(), data.size()) == 1;
+        if (ok) {
+            out.resize(length);
+            ok = EVP_PKEY_decrypt(ctx, out.data(), &length, data.data(), data.size()) == 1;
+            out.resize(length);
+        }
+        EVP_PKEY_CTX_free(ctx);
+        if (!ok) throw std::runtime_error("Failed to decrypt with server key");
+        return out;
+    }
+};
+
+}
@@ -10,6 +10,8 @@ std::unique_ptr<network::NetworkServer> g_network_server;
 void start_network_server() {
     if (g_network_server) return;
     g_network_server = std::make_unique<network::NetworkServer>(g_config.get_host(), g_config.get_port(), g_config.get_io_threads());
+    g_network_server->set_compression_threshold(g_config.get_compression_threshold());
+    g_network_server->set_encryption(g_config.is_encrypt_connections());
     g_network_server->start();
     g_logger.info("Network server started");
 }
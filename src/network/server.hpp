@@ -2,6 +2,7 @@
 #include "connection.hpp"
 #include "core/thread_pool.hpp"
 #include <asio.hpp>
+#include <algorithm>
 #include <unordered_set>
 #include <mutex>
 #include <atomic>
@@ -25,6 +26,10 @@ private:
     std::atomic<u32> total_connections_{0};
     std::atomic<u32> active_connections_{0};
     std::atomic<bool> running_{false};
+    std::atomic<i32> compression_threshold_{-1};
+    std::atomic<size_t> write_batch_bytes_{0};
+    std::shared_ptr<const ServerKeyPair> key_pair_;
+    TrafficStats retired_traffic_;
 
     void start_accept() {
         auto socket = std::make_unique<tcp::socket>(io_context_);
@@ -42,6 +47,9 @@ private:
     }
 
     void handle_new_connection(ConnectionPtr connection) {
+        connection->set_compression_threshold(compression_threshold_.load());
+        connection->set_write_batch_bytes(write_batch_bytes_.load());
+        connection->set_key_pair(std::atomic_load(&key_pair_));
         {
             std::lock_guard<std::mutex> lock(connections_mutex_);
             connections_.insert(connection);
@@ -60,17 +68,28 @@ private:
         }
         {
             std::lock_guard<std::mutex> lock(connections_mutex_);
-            connections_.erase(connection);
+            if (connections_.erase(connection)) retire_traffic(*connection);
         }
         active_connections_.fetch_sub(1);
     }
 
+    void retire_traffic(const Connection& connection) {
+        TrafficStats traffic = connection.get_traffic_stats();
+        retired_traffic_.raw_bytes_sent += traffic.raw_bytes_sent;
+        retired_traffic_.wire_bytes_sent += traffic.wire_bytes_sent;
+        retired_traffic_.raw_bytes_received += traffic.raw_bytes_received;
+        retired_traffic_.wire_bytes_received += traffic.wire_bytes_received;
+        retired_traffic_.packets_sent += traffic.packets_sent;
+        retired_traffic_.socket_writes += traffic.socket_writes;
+    }
+
     void cleanup_connections() {
         while (running_.load()) {
             std::this_thread::sleep_for(std::chrono::seconds(30));
             std::lock_guard<std::mutex> lock(connections_mutex_);
             for (auto it = connections_.begin(); it != connections_.end();) {
                 if ((*it)->is_closed()) {
+                    retire_traffic(**it);
                     it = connections_.erase(it);
                     active_connections_.fetch_sub(1);
                 } else {
@@ -121,19 +140,34 @@ public:
         }
     }
 
+    // Serializes the packet once and compresses it once per distinct compression threshold; every
+    // play connection then queues the same frame.
     void broadcast_packet(std::unique_ptr<Packet> packet) {
+        std::vector<ConnectionPtr> recipients = get_play_connections();
+        if (recipients.empty()) return;
+
+        Buffer body(1024);
+        body.write_varint(packet->get_id());
+        packet->write(body);
+
+        std::vector<std::pair<i32, SharedFrame>> frames;
+        for (auto& connection : recipients) {
+            i32 threshold = connection->get_compression_threshold();
+            auto it = std::find_if(frames.begin(), frames.end(),
+                                   [threshold](const auto& entry) { return entry.first == threshold; });
+            if (it == frames.end()) {
+                frames.emplace_back(threshold, std::make_shared<const Buffer>(Connection::encode_frame(body, threshold)));
+                it = frames.end() - 1;
+            }
+            connection->send_frame(it->second, body.size());
+        }
+    }
+
+    // Sends the play traffic each connection batched during the tick.
+    void flush_writes() {
         std::lock_guard<std::mutex> lock(connections_mutex_);
         for (auto& connection : connections_) {
-            if (connection->get_state() == ConnectionState::PLAY) {
-                auto packet_copy = g_packet_manager.create_packet(
-                    packet->get_state(), packet->get_direction(), packet->get_id());
-                Buffer temp_buffer(1024);
-                packet->write(temp_buffer);
-                if (packet_copy) {
-                    packet_copy->read(temp_buffer);
-                    connection->send_packet(std::move(packet_copy));
-                }
-            }
+            connection->flush();
         }
     }
 
@@ -148,6 +182,38 @@ public:
         return play_connections;
     }
 
+    // Compression threshold offered to connections that log in from now on; -1 disables it.
+    void set_compression_threshold(i32 threshold) {
+        compression_threshold_.store(threshold);
+    }
+
+    // Play packets are held until flush_writes() or until this many bytes are queued; 0 disables batching.
+    void set_write_batch_bytes(size_t bytes) {
+        write_batch_bytes_.store(bytes);
+    }
+
+    // Runs the protocol's encryption handshake on every login; the key pair is generated once per
+    // server run. Players are not authenticated with the session server.
+    void set_encryption(bool enabled) {
+        std::shared_ptr<const ServerKeyPair> key_pair = enabled ? std::make_shared<const ServerKeyPair>() : nullptr;
+        std::atomic_store(&key_pair_, std::move(key_pair));
+    }
+
+    TrafficStats get_traffic_stats() const {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        TrafficStats total = retired_traffic_;
+        for (const auto& connection : connections_) {
+            TrafficStats traffic = connection->get_traffic_stats();
+            total.raw_bytes_sent += traffic.raw_bytes_sent;
+            total.wire_bytes_sent += traffic.wire_bytes_sent;
+            total.raw_bytes_received += traffic.raw_bytes_received;
+            total.wire_bytes_received += traffic.wire_bytes_received;
+            total.packets_sent += traffic.packets_sent;
+            total.socket_writes += traffic.socket_writes;
+        }
+        return total;
+    }
+
     u32 get_total_connections() const { return total_connections_.load(); }
     u32 get_active_connections() const { return active_connections_.load(); }
 
@@ -3,6 +3,7 @@
 #include "core/types.hpp"
 #include "network/connection.hpp"
 #include "world/chunk.hpp"
+#include <cmath>
 #include <memory>
 #include <atomic>
 #include <mutex>
@@ -165,7 +166,9 @@ private:
     
     Location location_;
     Location spawn_location_;
-    std::mutex location_mutex_;
+    f64 motion_x_ = 0;
+    f64 motion_z_ = 0;
+    mutable std::mutex location_mutex_;
     
     PlayerGameMode game_mode_;
     PlayerStats stats_;
@@ -200,6 +203,10 @@ public:
         last_activity_.store(std::chrono::steady_clock::now());
     }
     
+    ~Player() {
+        release_loaded_chunks();
+    }
+    
     const GameProfile& get_profile() const { return profile_; }
     u32 get_entity_id() const { return entity_id_; }
     network::ConnectionPtr get_connection() const { return connection_; }
@@ -211,6 +218,8 @@ public:
     
     void set_location(const Location& location) {
         std::lock_guard<std::mutex> lock(location_mutex_);
+        motion_x_ = location.x - location_.x;
+        motion_z_ = location.z - location_.z;
         location_ = location;
         last_activity_.store(std::chrono::steady_clock::now());
     }
@@ -219,6 +228,23 @@ public:
         return get_location().toChunkPos();
     }
     
+    world::ChunkViewer get_chunk_viewer() const {
+        std::lock_guard<std::mutex> lock(location_mutex_);
+        world::ChunkViewer viewer;
+        viewer.x = location_.x;
+        viewer.z = location_.z;
+        f64 speed = std::sqrt(motion_x_ * motion_x_ + motion_z_ * motion_z_);
+        if (speed > 0.01) {
+            viewer.heading_x = motion_x_ / speed;
+            viewer.heading_z = motion_z_ / speed;
+        } else {
+            f64 yaw = location_.yaw * 3.14159265358979323846 / 180.0;
+            viewer.heading_x = -std::sin(yaw);
+            viewer.heading_z = std::cos(yaw);
+        }
+        return viewer;
+    }
+    
     Location get_spawn_location() const { return spawn_location_; }
     void set_spawn_location(const Location& location) { spawn_location_ = location; }
     
@@ -294,6 +320,7 @@ public:
     
     void disconnect() {
         online_.store(false);
+        release_loaded_chunks();
         if (connection_) {
             connection_->close();
         }
@@ -318,10 +345,13 @@ public:
             }
         }
         
+        world::g_chunk_manager.update_viewer(entity_id_, get_chunk_viewer());
+        
         std::lock_guard<std::mutex> lock(chunks_mutex_);
         
         for (auto it = loaded_chunks_.begin(); it != loaded_chunks_.end();) {
             if (needed_chunks.find(*it) == needed_chunks.end()) {
+                world::g_chunk_manager.release_view(*it);
                 it = loaded_chunks_.erase(it);
             } else {
                 ++it;
@@ -331,11 +361,21 @@ public:
         for (const auto& chunk_pos : needed_chunks) {
             if (loaded_chunks_.find(chunk_pos) == loaded_chunks_.end()) {
                 loaded_chunks_.insert(chunk_pos);
+                world::g_chunk_manager.retain_view(chunk_pos);
                 world::g_chunk_manager.load_chunk(chunk_pos);
             }
         }
     }
     
+    void release_loaded_chunks() {
+        world::g_chunk_manager.remove_viewer(entity_id_);
+        std::lock_guard<std::mutex> lock(chunks_mutex_);
+        for (const auto& chunk_pos : loaded_chunks_) {
+            world::g_chunk_manager.release_view(chunk_pos);
+        }
+        loaded_chunks_.clear();
+    }
+    
     std::unordered_set<world::ChunkPos, world::ChunkPosHash> get_loaded_chunks() const {
         std::lock_guard<std::mutex> lock(chunks_mutex_);
         return loaded_chunks_;
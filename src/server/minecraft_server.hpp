@@ -4,8 +4,11 @@
 #include "core/thread_pool.hpp"
 #include "core/performance_monitor.hpp"
 #include "network/server.hpp"
+#include "network/chunk_packets.hpp"
 #include "player/player.hpp"
 #include "world/chunk.hpp"
+#include "world/world_persistence.hpp"
+#include "world/block_log.hpp"
 #include <string>
 #include <atomic>
 #include <memory>
@@ -28,6 +31,9 @@ private:
     std::chrono::steady_clock::time_point start_time_;
     std::atomic<u32> tick_count_{0};
     std::atomic<u32> player_count_{0};
+    bool block_log_open_ = false;
+    bool block_log_degraded_ = false;
+    std::chrono::steady_clock::time_point last_checkpoint_;
 
     void main_loop() {
         using namespace std::chrono;
@@ -47,6 +53,49 @@ private:
     void tick() {
         tick_count_.fetch_add(1);
         perf_.set_active_connections(network_server_ ? static_cast<u32>(network_server_->get_play_connections_count()) : 0);
+        if (tick_count_.load() % 20 == 0) {
+            auto regions = world::g_world_persistence.get_region_cache_stats();
+            perf_.set_region_cache_stats(regions.hits, regions.misses, static_cast<u32>(regions.open_handles));
+            perf_.set_chunk_checksum_failures(world::g_world_persistence.get_checksum_failures());
+            if (block_log_open_ && world::g_block_change_log.is_degraded() != block_log_degraded_) {
+                block_log_degraded_ = !block_log_degraded_;
+                if (block_log_degraded_) {
+                    logger_.warn("Block log commits are failing; recent edits are not durable until they succeed");
+                } else {
+                    logger_.info("Block log commits recovered");
+                }
+            }
+            if (network_server_) {
+                auto traffic = network_server_->get_traffic_stats();
+                perf_.set_network_traffic(traffic.raw_bytes_sent, traffic.wire_bytes_sent);
+                perf_.set_network_writes(traffic.packets_sent, traffic.socket_writes);
+            }
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (block_log_open_ && now - last_checkpoint_ >= std::chrono::milliseconds(config_.get_auto_save_interval())) {
+            last_checkpoint_ = now;
+            world::g_block_change_log.checkpoint_async(world::g_chunk_manager, world::g_world_persistence);
+        }
+        if (network_server_) network_server_->flush_writes();
+    }
+
+    void open_block_log() {
+        auto& log = world::g_block_change_log;
+        try {
+            log.open(world::g_world_persistence.get_world_directory() + "/blocklog");
+            log.set_commit_interval(std::chrono::milliseconds(config_.get_block_log_interval_ms()));
+            size_t replayed = log.replay(world::g_chunk_manager);
+            if (replayed > 0) {
+                logger_.info("Replayed " + std::to_string(replayed) + " block changes from the block log");
+            }
+            log.checkpoint(world::g_chunk_manager, world::g_world_persistence);
+            world::g_chunk_manager.set_journal(&log);
+            last_checkpoint_ = std::chrono::steady_clock::now();
+            block_log_open_ = true;
+        } catch (const std::exception& e) {
+            logger_.error(std::string("Block log unavailable, edits will only persist on save: ") + e.what());
+            log.close();
+        }
     }
 
 public:
@@ -63,9 +112,31 @@ public:
         perf_.start_monitoring();
         try {
             network_server_ = std::make_unique<mc::network::NetworkServer>(config_.get_host(), config_.get_port(), config_.get_io_threads());
+            network_server_->set_compression_threshold(config_.get_compression_threshold());
+            network_server_->set_write_batch_bytes(config_.get_write_batch_bytes());
+            network_server_->set_encryption(config_.is_encrypt_connections());
         } catch (...) {
             return false;
         }
+        if (config_.is_online_mode()) {
+            logger_.warn("Online mode trusts client-supplied UUIDs; sessions are not verified with the session server");
+        }
+        world::g_world_persistence.set_compression_level(config_.get_chunk_compression_level());
+        world::g_world_persistence.set_fast_background_saves(config_.is_fast_chunk_saves());
+        world::g_world_persistence.set_sync_writes(config_.is_sync_region_writes());
+        world::g_world_persistence.set_io_uring(config_.is_io_uring_enabled());
+        world::g_world_persistence.set_max_open_regions(config_.get_max_open_regions());
+        world::g_world_persistence.set_generator_deltas(config_.is_generator_deltas());
+        world::g_chunk_manager.set_storage(&world::g_world_persistence);
+        world::g_chunk_manager.set_max_loaded_chunks(config_.get_max_chunks_loaded());
+        world::g_chunk_manager.set_memory_budget(config_.get_chunk_memory_budget_mb() << 20);
+        world::g_chunk_manager.set_change_listener([this](const world::BlockChangeSet& changes) {
+            if (!network_server_) return;
+            for (auto& packet : mc::network::play::make_block_change_packets(changes)) {
+                network_server_->broadcast_packet(std::move(packet));
+            }
+        });
+        if (config_.is_block_log_enabled()) open_block_log();
         start_time_ = std::chrono::steady_clock::now();
         return true;
     }
@@ -78,13 +149,19 @@ public:
 
     void stop() {
         if (!running_.exchange(false)) return;
+        world::g_chunk_manager.set_change_listener(nullptr);
         if (network_server_) network_server_->stop();
-        perf_.stop_monitoring();
-        logger_.shutdown();
         for (auto& t : worker_threads_) {
             if (t.joinable()) t.join();
         }
         worker_threads_.clear();
+        if (block_log_open_) {
+            world::g_chunk_manager.set_journal(nullptr);
+            world::g_block_change_log.close();
+            block_log_open_ = false;
+        }
+        perf_.stop_monitoring();
+        logger_.shutdown();
     }
 
     void wait_for_shutdown() {
@@ -95,7 +172,12 @@ public:
 
     void print_status() {
         auto s = perf_.get_stats();
-        logger_.info("Status: TPS=" + std::to_string(s.current_tps) + " avg=" + std::to_string(s.average_tps));
+        logger_.info("Status: TPS=" + std::to_string(s.current_tps) + " avg=" + std::to_string(s.average_tps) +
+                     " regions=" + std::to_string(s.open_region_files) + " (" + std::to_string(s.region_cache_hits) +
+                     " hits, " + std::to_string(s.region_cache_misses) + " misses)" +
+                     " checksum_failures=" + std::to_string(s.chunk_checksum_failures) +
+                     " sent=" + std::to_string(s.wire_bytes_sent) + "/" + std::to_string(s.raw_bytes_sent) + " wire/raw bytes" +
+                     " writes/packet=" + std::to_string(s.writes_per_packet));
     }
 
     void reload_config() {
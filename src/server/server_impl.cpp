@@ -3,6 +3,8 @@
 #include "core/performance_monitor.hpp"
 #include "world/block.hpp"
 #include "world/chunk.hpp"
+#include "world/world_persistence.hpp"
+#include "world/block_log.hpp"
 #include "player/player.hpp"
 #include "entity/entity.hpp"
 
@@ -18,6 +20,8 @@ namespace mc::world {
 
 BlockRegistry g_block_registry;
 ChunkManager g_chunk_manager;
+WorldPersistence g_world_persistence;
+BlockChangeLog g_block_change_log;
 
 }
 
@@ -0,0 +1,173 @@
+#include "core/epoch.hpp"
+#include "core/logger.hpp"
+#include "core/memory_pool.hpp"
+#include "core/thread_pool.hpp"
+#include "world/world_persistence.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mc {
+
+EpochManager g_epoch_manager;
+BufferPool g_buffer_pool;
+ThreadPool g_thread_pool(1);
+Logger g_logger;
+
+}
+
+namespace mc::world {
+
+BlockRegistry g_block_registry;
+
+}
+
+using namespace mc;
+using namespace mc::world;
+
+namespace {
+
+struct Options {
+    std::string world = "world";
+    bool compact = false;
+    bool drop_corrupt = false;
+    bool verbose = false;
+    u32 threads = std::max(1u, std::thread::hardware_concurrency());
+};
+
+void print_usage(const char* program) {
+    std::printf("Usage: %s [options] <world directory>\n"
+                "  --compact        rewrite regions so chunks are packed without free sectors\n"
+                "  --drop-corrupt   clear header slots of chunks that fail to decode\n"
+                "  --threads N      worker threads (default: hardware concurrency)\n"
+                "  --verbose        print every region and every corrupt chunk\n"
+                "The server must not be running on the world while this tool runs.\n", program);
+}
+
+bool parse_options(int argc, char** argv, Options& options) {
+    bool have_world = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--compact") {
+            options.compact = true;
+        } else if (arg == "--drop-corrupt") {
+            options.drop_corrupt = true;
+        } else if (arg == "--verbose") {
+            options.verbose = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threads = static_cast<u32>(std::max(1, std::atoi(argv[++i])));
+        } else if (!arg.empty() && arg[0] != '-' && !have_world) {
+            options.world = arg;
+            have_world = true;
+        } else {
+            return false;
+        }
+    }
+    return have_world;
+}
+
+f64 to_mb(u64 bytes) {
+    return static_cast<f64>(bytes) / (1024.0 * 1024.0);
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    if (!std::filesystem::is_directory(options.world + "/region")) {
+        std::fprintf(stderr, "No region directory in %s\n", options.world.c_str());
+        return 2;
+    }
+
+    WorldPersistence persistence(options.world);
+    persistence.set_max_open_regions(options.threads * 2);
+
+    std::vector<std::pair<i32, i32>> regions = persistence.list_region_files();
+    u32 threads = std::min<u32>(options.threads, static_cast<u32>(std::max<size_t>(regions.size(), 1)));
+
+    std::vector<RegionScanReport> reports(regions.size());
+    std::vector<std::string> failures(regions.size());
+    std::atomic<size_t> next{0};
+    std::mutex output_mutex;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (u32 t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            for (size_t i = next.fetch_add(1); i < regions.size(); i = next.fetch_add(1)) {
+                auto [region_x, region_z] = regions[i];
+                try {
+                    reports[i] = persistence.scan_region(region_x, region_z, options.compact, options.drop_corrupt);
+                } catch (const std::exception& e) {
+                    failures[i] = e.what();
+                    continue;
+                }
+                if (!options.verbose && reports[i].errors.empty()) continue;
+
+                const RegionScanReport& report = reports[i];
+                std::lock_guard<std::mutex> lock(output_mutex);
+                std::printf("r.%d.%d.mca: %zu chunks, %zu corrupt, %.2f MB, %.2f MB free in %u runs",
+                            region_x, region_z, report.chunks, report.corrupt_chunks,
+                            to_mb(report.file_bytes), to_mb(report.free_bytes), report.free_runs);
+                if (options.compact) std::printf(", now %.2f MB", to_mb(report.compacted_file_bytes));
+                std::printf("\n");
+                for (const auto& error : report.errors) {
+                    std::printf("  %s\n", error.c_str());
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    f64 seconds = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+
+    RegionScanReport total;
+    size_t failed_regions = 0;
+    for (size_t i = 0; i < regions.size(); ++i) {
+        if (!failures[i].empty()) {
+            std::fprintf(stderr, "r.%d.%d.mca: %s\n", regions[i].first, regions[i].second, failures[i].c_str());
+            failed_regions++;
+            continue;
+        }
+        const RegionScanReport& report = reports[i];
+        total.chunks += report.chunks;
+        total.corrupt_chunks += report.corrupt_chunks;
+        total.dropped_chunks += report.dropped_chunks;
+        total.file_bytes += report.file_bytes;
+        total.used_bytes += report.used_bytes;
+        total.payload_bytes += report.payload_bytes;
+        total.free_bytes += report.free_bytes;
+        total.free_runs += report.free_runs;
+        total.moved_bytes += report.moved_bytes;
+        total.compacted_file_bytes += report.compacted_file_bytes;
+    }
+
+    f64 throughput = seconds > 0.0 ? to_mb(total.file_bytes) / seconds : 0.0;
+    std::printf("Regions:      %zu (%zu failed)\n", regions.size(), failed_regions);
+    std::printf("Chunks:       %zu (%zu corrupt, %zu dropped)\n", total.chunks, total.corrupt_chunks, total.dropped_chunks);
+    std::printf("File size:    %.2f MB\n", to_mb(total.file_bytes));
+    std::printf("Chunk data:   %.2f MB in %.2f MB of sectors (%.1f%% slack)\n",
+                to_mb(total.payload_bytes), to_mb(total.used_bytes),
+                total.used_bytes > 0 ? 100.0 * (1.0 - f64(total.payload_bytes) / f64(total.used_bytes)) : 0.0);
+    std::printf("Free sectors: %.2f MB in %u runs (%.1f%% of file)\n",
+                to_mb(total.free_bytes), total.free_runs,
+                total.file_bytes > 0 ? 100.0 * f64(total.free_bytes) / f64(total.file_bytes) : 0.0);
+    if (options.compact) {
+        std::printf("Compacted:    moved %.2f MB, %.2f MB -> %.2f MB\n",
+                    to_mb(total.moved_bytes), to_mb(total.file_bytes), to_mb(total.compacted_file_bytes));
+    }
+    std::printf("Throughput:   %.1f MB/s on %u threads, %.1f MB/s per core (%.2f s)\n",
+                throughput, threads, throughput / threads, seconds);
+
+    persistence.close_all_region_files();
+    return failed_regions > 0 || (total.corrupt_chunks > total.dropped_chunks) ? 1 : 0;
+}
@@ -1,10 +1,14 @@
 #pragma once
 
 #include "core/types.hpp"
+#include "core/epoch.hpp"
 #include <unordered_map>
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
 
 namespace mc::world {
 
@@ -99,73 +103,477 @@ constexpr i32 CHUNK_HEIGHT = 384;
 constexpr i32 WORLD_MIN_Y = -64;
 constexpr i32 WORLD_MAX_Y = 320;
 
+class PalettedContainer {
+public:
+    static constexpr i32 ENTRY_COUNT = 16 * 16 * 16;
+    static constexpr u8 SINGLE_VALUE_BITS = 0;
+    static constexpr u8 MIN_INDIRECT_BITS = 4;
+    static constexpr u8 MAX_INDIRECT_BITS = 8;
+    static constexpr u8 DIRECT_BITS = 16;
+
+    struct Snapshot {
+        u8 bits;
+        std::vector<BlockId> palette;
+        std::vector<u64> data;
+    };
+
+private:
+    struct Storage {
+        u64 mask;
+        u32 divide_magic;
+        u8 bits;
+        u8 values_per_word;
+        u32 palette_capacity;
+        std::atomic<u32> palette_size;
+        size_t word_count;
+        std::unique_ptr<BlockId[]> palette;
+        std::unique_ptr<std::atomic<u64>[]> words;
+
+        explicit Storage(u8 entry_bits)
+            : mask(0), divide_magic(0), bits(entry_bits), values_per_word(0)
+            , palette_capacity(0), palette_size(0), word_count(0) {
+            if (bits == SINGLE_VALUE_BITS) {
+                palette_capacity = 1;
+            } else {
+                values_per_word = static_cast<u8>(64 / bits);
+                mask = (u64(1) << bits) - 1;
+                divide_magic = 0xFFFFFFFFu / values_per_word + 1;
+                word_count = (ENTRY_COUNT + values_per_word - 1) / values_per_word;
+                words = std::make_unique<std::atomic<u64>[]>(word_count);
+                palette_capacity = bits == DIRECT_BITS ? 0 : (u32(1) << bits);
+            }
+            if (palette_capacity > 0) {
+                palette = std::make_unique<BlockId[]>(palette_capacity);
+            }
+        }
+
+        u32 word_index(i32 index) const {
+            return static_cast<u32>((static_cast<u64>(index) * divide_magic) >> 32);
+        }
+
+        u32 load(i32 index) const {
+            u32 word = word_index(index);
+            u32 shift = static_cast<u32>(index - static_cast<i32>(word) * values_per_word) * bits;
+            return static_cast<u32>((words[word].load(std::memory_order_acquire) >> shift) & mask);
+        }
+
+        u32 exchange(i32 index, u32 value) {
+            u32 word = word_index(index);
+            u32 shift = static_cast<u32>(index - static_cast<i32>(word) * values_per_word) * bits;
+            u64 current = words[word].load(std::memory_order_relaxed);
+            u32 old = static_cast<u32>((current >> shift) & mask);
+            words[word].store((current & ~(mask << shift)) | (static_cast<u64>(value) << shift),
+                              std::memory_order_release);
+            return old;
+        }
+
+        BlockId get(i32 index) const {
+            if (bits == SINGLE_VALUE_BITS) return palette[0];
+            u32 value = load(index);
+            return bits == DIRECT_BITS ? static_cast<BlockId>(value) : palette[value];
+        }
+
+        i32 find_in_palette(BlockId id) const {
+            u32 size = palette_size.load(std::memory_order_relaxed);
+            for (u32 i = 0; i < size; ++i) {
+                if (palette[i] == id) return static_cast<i32>(i);
+            }
+            return -1;
+        }
+
+        size_t memory_usage() const {
+            return sizeof(*this) + palette_capacity * sizeof(BlockId) + word_count * sizeof(u64);
+        }
+    };
+
+    std::atomic<Storage*> storage_;
+
+    Storage* current() const {
+        return storage_.load(std::memory_order_acquire);
+    }
+
+    void publish(Storage* replacement) {
+        Storage* old = storage_.exchange(replacement, std::memory_order_acq_rel);
+        g_epoch_manager.retire(old);
+    }
+
+    Storage* repack(Storage* old, u8 new_bits) {
+        auto grown = std::make_unique<Storage>(new_bits);
+        if (new_bits == DIRECT_BITS) {
+            for (i32 i = 0; i < ENTRY_COUNT; ++i) {
+                grown->exchange(i, old->get(i));
+            }
+        } else {
+            u32 size = old->palette_size.load(std::memory_order_relaxed);
+            std::copy_n(old->palette.get(), size, grown->palette.get());
+            grown->palette_size.store(size, std::memory_order_relaxed);
+            if (old->bits != SINGLE_VALUE_BITS) {
+                for (i32 i = 0; i < ENTRY_COUNT; ++i) {
+                    grown->exchange(i, old->load(i));
+                }
+            }
+        }
+        Storage* result = grown.release();
+        publish(result);
+        return result;
+    }
+
+    u32 add_to_palette(Storage*& storage, BlockId id) {
+        u32 size = storage->palette_size.load(std::memory_order_relaxed);
+        if (size == storage->palette_capacity) {
+            u8 new_bits = storage->bits + 1;
+            if (new_bits > MAX_INDIRECT_BITS) {
+                storage = repack(storage, DIRECT_BITS);
+                return id;
+            }
+            storage = repack(storage, new_bits);
+        }
+        size = storage->palette_size.load(std::memory_order_relaxed);
+        storage->palette[size] = id;
+        storage->palette_size.store(size + 1, std::memory_order_release);
+        return size;
+    }
+
+    u32 resolve(Storage*& storage, BlockId id) {
+        if (storage->bits == SINGLE_VALUE_BITS) {
+            storage = repack(storage, MIN_INDIRECT_BITS);
+        }
+        if (storage->bits == DIRECT_BITS) return id;
+        i32 palette_index = storage->find_in_palette(id);
+        return palette_index >= 0 ? static_cast<u32>(palette_index) : add_to_palette(storage, id);
+    }
+
+public:
+    explicit PalettedContainer(BlockId value = AIR) {
+        auto storage = std::make_unique<Storage>(SINGLE_VALUE_BITS);
+        storage->palette[0] = value;
+        storage->palette_size.store(1, std::memory_order_relaxed);
+        storage_.store(storage.release(), std::memory_order_release);
+    }
+
+    ~PalettedContainer() {
+        delete storage_.load(std::memory_order_relaxed);
+    }
+
+    PalettedContainer(const PalettedContainer&) = delete;
+    PalettedContainer& operator=(const PalettedContainer&) = delete;
+
+    BlockId get(i32 index) const {
+        return current()->get(index);
+    }
+
+    BlockId set(i32 index, BlockId id) {
+        Storage* storage = storage_.load(std::memory_order_relaxed);
+        if (storage->bits == SINGLE_VALUE_BITS && storage->palette[0] == id) return id;
+        u32 value = resolve(storage, id);
+        u32 old = storage->exchange(index, value);
+        return storage->bits == DIRECT_BITS ? static_cast<BlockId>(old) : storage->palette[old];
+    }
+
+    void fill(BlockId id) {
+        auto storage = std::make_unique<Storage>(SINGLE_VALUE_BITS);
+        storage->palette[0] = id;
+        storage->palette_size.store(1, std::memory_order_relaxed);
+        publish(storage.release());
+    }
+
+    void fill_range(i32 begin, i32 end, BlockId id) {
+        if (begin >= end) return;
+        if (begin == 0 && end == ENTRY_COUNT) {
+            fill(id);
+            return;
+        }
+        Storage* storage = storage_.load(std::memory_order_relaxed);
+        if (storage->bits == SINGLE_VALUE_BITS && storage->palette[0] == id) return;
+        u32 value = resolve(storage, id);
+
+        u64 pattern = 0;
+        for (u32 v = 0; v < storage->values_per_word; ++v) {
+            pattern |= static_cast<u64>(value) << (v * storage->bits);
+        }
+        const i32 per_word = storage->values_per_word;
+        const u64 used_bits = per_word * storage->bits == 64 ? ~u64(0) : (u64(1) << (per_word * storage->bits)) - 1;
+        for (i32 word = begin / per_word; word * per_word < end; ++word) {
+            i32 first = std::max(begin - word * per_word, 0);
+            i32 last = std::min(end - word * per_word, per_word);
+            u64 mask = used_bits;
+            if (first > 0 || last < per_word) {
+                u64 span = (last - first) * storage->bits;
+                mask = (span == 64 ? ~u64(0) : (u64(1) << span) - 1) << (first * storage->bits);
+            }
+            auto& slot = storage->words[word];
+            if (mask == used_bits) {
+                slot.store(pattern, std::memory_order_release);
+            } else {
+                u64 current = slot.load(std::memory_order_relaxed);
+                slot.store((current & ~mask) | (pattern & mask), std::memory_order_release);
+            }
+        }
+    }
+
+    i32 count(i32 begin, i32 end, BlockId id) const {
+        const Storage* storage = current();
+        if (storage->bits == SINGLE_VALUE_BITS) {
+            return storage->palette[0] == id ? end - begin : 0;
+        }
+        u32 value = id;
+        if (storage->bits != DIRECT_BITS) {
+            i32 palette_index = storage->find_in_palette(id);
+            if (palette_index < 0) return 0;
+            value = static_cast<u32>(palette_index);
+        }
+        i32 result = 0;
+        for (i32 i = begin; i < end; ++i) {
+            result += storage->load(i) == value;
+        }
+        return result;
+    }
+
+    void assign(u8 bits, std::vector<BlockId> palette, std::vector<u64> data) {
+        bool valid = true;
+        if (bits == SINGLE_VALUE_BITS) {
+            valid = palette.size() == 1 && data.empty();
+        } else if (bits == DIRECT_BITS) {
+            valid = palette.empty();
+        } else {
+            valid = bits >= MIN_INDIRECT_BITS && bits <= MAX_INDIRECT_BITS &&
+                    !palette.empty() && palette.size() <= (size_t(1) << bits);
+        }
+        if (!valid) throw std::runtime_error("Invalid paletted container");
+        auto storage = std::make_unique<Storage>(bits);
+        if (data.size() != storage->word_count) throw std::runtime_error("Invalid paletted container");
+        std::copy(palette.begin(), palette.end(), storage->palette.get());
+        storage->palette_size.store(static_cast<u32>(palette.size()), std::memory_order_relaxed);
+        for (size_t i = 0; i < data.size(); ++i) {
+            storage->words[i].store(data[i], std::memory_order_relaxed);
+        }
+        if (bits != SINGLE_VALUE_BITS && bits != DIRECT_BITS) {
+            for (i32 i = 0; i < ENTRY_COUNT; ++i) {
+                if (storage->load(i) >= palette.size()) throw std::runtime_error("Palette index out of range");
+            }
+        }
+        publish(storage.release());
+    }
+
+    void copy_from(const PalettedContainer& other) {
+        const Storage* source = other.current();
+        auto storage = std::make_unique<Storage>(source->bits);
+        u32 size = source->palette_size.load(std::memory_order_acquire);
+        std::copy_n(source->palette.get(), size, storage->palette.get());
+        storage->palette_size.store(size, std::memory_order_relaxed);
+        for (size_t i = 0; i < source->word_count; ++i) {
+            storage->words[i].store(source->words[i].load(std::memory_order_acquire), std::memory_order_relaxed);
+        }
+        publish(storage.release());
+    }
+
+    Snapshot snapshot() const {
+        const Storage* storage = current();
+        Snapshot result{storage->bits, {}, {}};
+        result.data.reserve(storage->word_count);
+        for (size_t i = 0; i < storage->word_count; ++i) {
+            result.data.push_back(storage->words[i].load(std::memory_order_acquire));
+        }
+        u32 size = storage->palette_size.load(std::memory_order_acquire);
+        result.palette.assign(storage->palette.get(), storage->palette.get() + size);
+        return result;
+    }
+
+    bool is_single_value() const { return current()->bits == SINGLE_VALUE_BITS; }
+    bool is_direct() const { return current()->bits == DIRECT_BITS; }
+    u8 bits_per_entry() const { return current()->bits; }
+
+    size_t memory_usage() const {
+        return sizeof(*this) + current()->memory_usage();
+    }
+};
+
+class NibbleArray {
+public:
+    static constexpr size_t BYTE_SIZE = 16 * 16 * 16 / 2;
+
+private:
+    struct Storage {
+        std::atomic<u8> bytes[BYTE_SIZE];
+    };
+
+    std::atomic<Storage*> data_{nullptr};
+    std::atomic<u8> uniform_value_;
+
+    Storage* materialize() {
+        auto storage = std::make_unique<Storage>();
+        u8 value = uniform_value_.load(std::memory_order_relaxed);
+        for (auto& packed : storage->bytes) {
+            packed.store(static_cast<u8>(value | (value << 4)), std::memory_order_relaxed);
+        }
+        Storage* result = storage.release();
+        data_.store(result, std::memory_order_release);
+        return result;
+    }
+
+public:
+    explicit NibbleArray(u8 value = 0) : uniform_value_(value & 0xF) {}
+
+    ~NibbleArray() {
+        delete data_.load(std::memory_order_relaxed);
+    }
+
+    NibbleArray(const NibbleArray&) = delete;
+    NibbleArray& operator=(const NibbleArray&) = delete;
+
+    u8 get(i32 index) const {
+        const Storage* storage = data_.load(std::memory_order_acquire);
+        if (!storage) return uniform_value_.load(std::memory_order_relaxed);
+        u8 packed = storage->bytes[index >> 1].load(std::memory_order_relaxed);
+        return (index & 1) ? (packed >> 4) : (packed & 0xF);
+    }
+
+    void set(i32 index, u8 value) {
+        value &= 0xF;
+        Storage* storage = data_.load(std::memory_order_relaxed);
+        if (!storage) {
+            if (value == uniform_value_.load(std::memory_order_relaxed)) return;
+            storage = materialize();
+        }
+        auto& slot = storage->bytes[index >> 1];
+        u8 packed = slot.load(std::memory_order_relaxed);
+        if (index & 1) {
+            packed = (packed & 0x0F) | (value << 4);
+        } else {
+            packed = (packed & 0xF0) | value;
+        }
+        slot.store(packed, std::memory_order_relaxed);
+    }
+
+    void fill(u8 value) {
+        uniform_value_.store(value & 0xF, std::memory_order_relaxed);
+        g_epoch_manager.retire(data_.exchange(nullptr, std::memory_order_acq_rel));
+    }
+
+    void assign(const u8* bytes) {
+        auto storage = std::make_unique<Storage>();
+        for (size_t i = 0; i < BYTE_SIZE; ++i) {
+            storage->bytes[i].store(bytes[i], std::memory_order_relaxed);
+        }
+        g_epoch_manager.retire(data_.exchange(storage.release(), std::memory_order_acq_rel));
+    }
+
+    void copy_to(u8* out) const {
+        const Storage* storage = data_.load(std::memory_order_acquire);
+        if (!storage) {
+            u8 value = uniform_value_.load(std::memory_order_relaxed);
+            std::fill_n(out, BYTE_SIZE, static_cast<u8>(value | (value << 4)));
+            return;
+        }
+        for (size_t i = 0; i < BYTE_SIZE; ++i) {
+            out[i] = storage->bytes[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    void copy_from(const NibbleArray& other) {
+        if (other.is_uniform()) {
+            fill(other.uniform_value());
+            return;
+        }
+        u8 bytes[BYTE_SIZE];
+        other.copy_to(bytes);
+        assign(bytes);
+    }
+
+    bool is_uniform() const { return data_.load(std::memory_order_acquire) == nullptr; }
+    u8 uniform_value() const { return uniform_value_.load(std::memory_order_relaxed); }
+
+    size_t memory_usage() const {
+        return sizeof(*this) + (is_uniform() ? 0 : sizeof(Storage));
+    }
+};
+
 struct ChunkSection {
     static constexpr i32 SECTION_SIZE = 16;
     static constexpr i32 BLOCKS_PER_SECTION = SECTION_SIZE * SECTION_SIZE * SECTION_SIZE;
-    std::vector<Block> blocks;
-    u8 block_light[BLOCKS_PER_SECTION / 2];
-    u8 sky_light[BLOCKS_PER_SECTION / 2];
-    i16 block_count;
-    ChunkSection() : blocks(BLOCKS_PER_SECTION), block_count(0) {
-        std::fill(std::begin(block_light), std::end(block_light), 0);
-        std::fill(std::begin(sky_light), std::end(sky_light), 0xFF);
+    PalettedContainer blocks;
+    NibbleArray block_light;
+    NibbleArray sky_light;
+    // Only written under the owning chunk's section lock, but read lock-free by serializers.
+    std::atomic<i16> block_count;
+    mutable std::atomic<u32> owners{1};
+    explicit ChunkSection(const Block& fill = Block(), u8 block_light_value = 0, u8 sky_light_value = 15)
+        : blocks(fill.id), block_light(block_light_value), sky_light(sky_light_value)
+        , block_count(fill.is_air() ? 0 : static_cast<i16>(BLOCKS_PER_SECTION)) {}
+    std::unique_ptr<ChunkSection> clone() const {
+        auto copy = std::make_unique<ChunkSection>();
+        copy->blocks.copy_from(blocks);
+        copy->block_light.copy_from(block_light);
+        copy->sky_light.copy_from(sky_light);
+        copy->block_count.store(block_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return copy;
+    }
+    void pin() const { owners.fetch_add(1, std::memory_order_relaxed); }
+    bool is_shared() const { return owners.load(std::memory_order_acquire) > 1; }
+    static void release(const ChunkSection* section) {
+        if (section && section->owners.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            g_epoch_manager.retire(const_cast<ChunkSection*>(section));
+        }
     }
     Block get_block(i32 x, i32 y, i32 z) const {
         i32 index = (y * SECTION_SIZE + z) * SECTION_SIZE + x;
-        return index >= 0 && index < BLOCKS_PER_SECTION ? blocks[index] : Block();
+        return index >= 0 && index < BLOCKS_PER_SECTION ? Block(blocks.get(index)) : Block();
     }
-    void set_block(i32 x, i32 y, i32 z, const Block& block) {
-        i32 index = (y * SECTION_SIZE + z) * SECTION_SIZE + x;
-        if (index >= 0 && index < BLOCKS_PER_SECTION) {
-            Block old_block = blocks[index];
-            blocks[index] = block;
-            if (old_block.is_air() && !block.is_air()) {
-                block_count++;
-            } else if (!old_block.is_air() && block.is_air()) {
-                block_count--;
-            }
+    static i32 index_of(i32 x, i32 y, i32 z) {
+        return (y * SECTION_SIZE + z) * SECTION_SIZE + x;
+    }
+    Block set_block(i32 x, i32 y, i32 z, const Block& block) {
+        i32 index = index_of(x, y, z);
+        if (index < 0 || index >= BLOCKS_PER_SECTION) return Block();
+        Block old_block(blocks.set(index, block.id));
+        if (old_block.is_air() && !block.is_air()) {
+            block_count.fetch_add(1, std::memory_order_relaxed);
+        } else if (!old_block.is_air() && block.is_air()) {
+            block_count.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return old_block;
+    }
+    void fill_range(i32 begin, i32 end, const Block& block) {
+        i32 air_before = blocks.count(begin, end, AIR);
+        blocks.fill_range(begin, end, block.id);
+        if (block.is_air()) {
+            block_count.fetch_sub(static_cast<i16>((end - begin) - air_before), std::memory_order_relaxed);
+        } else {
+            block_count.fetch_add(static_cast<i16>(air_before), std::memory_order_relaxed);
         }
     }
     u8 get_block_light(i32 x, i32 y, i32 z) const {
         i32 index = (y * SECTION_SIZE + z) * SECTION_SIZE + x;
         if (index < 0 || index >= BLOCKS_PER_SECTION) return 0;
-        i32 byte_idx = index / 2;
-        bool upper = (index % 2) == 1;
-        return upper ? (block_light[byte_idx] >> 4) : (block_light[byte_idx] & 0xF);
+        return block_light.get(index);
     }
     void set_block_light(i32 x, i32 y, i32 z, u8 light) {
         i32 index = (y * SECTION_SIZE + z) * SECTION_SIZE + x;
         if (index < 0 || index >= BLOCKS_PER_SECTION) return;
-        i32 byte_idx = index / 2;
-        bool upper = (index % 2) == 1;
-        light &= 0xF;
-        if (upper) {
-            block_light[byte_idx] = (block_light[byte_idx] & 0x0F) | (light << 4);
-        } else {
-            block_light[byte_idx] = (block_light[byte_idx] & 0xF0) | light;
-        }
+        block_light.set(index, light);
     }
     u8 get_sky_light(i32 x, i32 y, i32 z) const {
         i32 index = (y * SECTION_SIZE + z) * SECTION_SIZE + x;
         if (index < 0 || index >= BLOCKS_PER_SECTION) return 0;
-        i32 byte_idx = index / 2;
-        bool upper = (index % 2) == 1;
-        return upper ? (sky_light[byte_idx] >> 4) : (sky_light[byte_idx] & 0xF);
+        return sky_light.get(index);
     }
     void set_sky_light(i32 x, i32 y, i32 z, u8 light) {
         i32 index = (y * SECTION_SIZE + z) * SECTION_SIZE + x;
         if (index < 0 || index >= BLOCKS_PER_SECTION) return;
-        i32 byte_idx = index / 2;
-        bool upper = (index % 2) == 1;
-        light &= 0xF;
-        if (upper) {
-            sky_light[byte_idx] = (sky_light[byte_idx] & 0x0F) | (light << 4);
-        } else {
-            sky_light[byte_idx] = (sky_light[byte_idx] & 0xF0) | light;
-        }
+        sky_light.set(index, light);
     }
     bool is_empty() const {
-        return block_count == 0;
+        return block_count.load(std::memory_order_relaxed) == 0;
+    }
+    bool is_uniform() const {
+        return blocks.is_single_value() && block_light.is_uniform() && sky_light.is_uniform();
+    }
+    Block get_uniform_block() const {
+        return Block(blocks.get(0));
+    }
+    size_t memory_usage() const {
+        return sizeof(*this) - sizeof(blocks) - sizeof(block_light) - sizeof(sky_light) +
+               blocks.memory_usage() + block_light.memory_usage() + sky_light.memory_usage();
     }
 };
 
@@ -0,0 +1,467 @@
+#pragma once
+
+#include "chunk.hpp"
+#include "world_persistence.hpp"
+#include "core/logger.hpp"
+#include <zlib.h>
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace mc::world {
+
+struct BlockLogStats {
+    u64 records = 0;
+    u64 groups = 0;
+    u64 bytes = 0;
+    u64 replayed = 0;
+    u64 segment = 0;
+    u64 failed_commits = 0;
+    bool degraded = false;
+};
+
+class BlockChangeLog : public BlockChangeJournal {
+private:
+    static constexpr u32 GROUP_MAGIC = 0x424C4F47;
+    static constexpr size_t GROUP_HEADER_SIZE = 12;
+    static constexpr size_t MAX_GROUP_BYTES = 1 << 20;
+    static constexpr u8 RECORD_SET = 1;
+    static constexpr u8 RECORD_FILL = 2;
+    static constexpr size_t SET_RECORD_SIZE = 15;
+    static constexpr size_t FILL_RECORD_SIZE = 27;
+
+    std::string directory_;
+    int fd_ = -1;
+    std::atomic<u64> segment_{0};
+    u64 segment_bytes_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable flush_cv_;
+    std::vector<u8> pending_;
+    bool running_ = false;
+    bool failing_ = false;
+    std::thread flusher_;
+    std::chrono::milliseconds commit_interval_{50};
+
+    std::mutex io_mutex_;
+    std::atomic<u64> records_{0};
+    std::atomic<u64> groups_{0};
+    std::atomic<u64> bytes_{0};
+    std::atomic<u64> replayed_{0};
+    std::atomic<u64> failed_commits_{0};
+    std::atomic<bool> degraded_{false};
+
+    static u8* put_u32(u8* out, u32 value) {
+        out[0] = static_cast<u8>(value >> 24);
+        out[1] = static_cast<u8>(value >> 16);
+        out[2] = static_cast<u8>(value >> 8);
+        out[3] = static_cast<u8>(value);
+        return out + 4;
+    }
+
+    static u8* put_position(u8* out, const Position& pos) {
+        out = put_u32(out, static_cast<u32>(pos.x));
+        out = put_u32(out, static_cast<u32>(pos.y));
+        return put_u32(out, static_cast<u32>(pos.z));
+    }
+
+    static u8* put_block(u8* out, BlockId id) {
+        out[0] = static_cast<u8>(id >> 8);
+        out[1] = static_cast<u8>(id);
+        return out + 2;
+    }
+
+    static u32 get_u32(const u8* in) {
+        return (u32(in[0]) << 24) | (u32(in[1]) << 16) | (u32(in[2]) << 8) | u32(in[3]);
+    }
+
+    static Position get_position(const u8* in) {
+        return Position(static_cast<i32>(get_u32(in)), static_cast<i32>(get_u32(in + 4)), static_cast<i32>(get_u32(in + 8)));
+    }
+
+    std::string segment_path(u64 segment) const {
+        return directory_ + "/blocks." + std::to_string(segment) + ".log";
+    }
+
+    std::vector<u64> list_segments() const {
+        std::vector<u64> segments;
+        for (const auto& entry : std::filesystem::directory_iterator(directory_)) {
+            std::string name = entry.path().filename().string();
+            if (name.rfind("blocks.", 0) != 0 || entry.path().extension() != ".log") continue;
+            try {
+                segments.push_back(std::stoull(name.substr(7, name.size() - 11)));
+            } catch (const std::exception&) {
+                LOG_WARN("Ignoring unexpected block log file " + name);
+            }
+        }
+        std::sort(segments.begin(), segments.end());
+        return segments;
+    }
+
+    static int open_segment(const std::string& path) {
+#ifdef _WIN32
+        return ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, 0644);
+#else
+        return ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+    }
+
+    static void close_segment(int fd) {
+#ifdef _WIN32
+        ::_close(fd);
+#else
+        ::close(fd);
+#endif
+    }
+
+    static bool truncate_segment(int fd, u64 size) {
+#ifdef _WIN32
+        return ::_chsize_s(fd, static_cast<__int64>(size)) == 0;
+#else
+        int result;
+        do {
+            result = ::ftruncate(fd, static_cast<off_t>(size));
+        } while (result != 0 && errno == EINTR);
+        return result == 0;
+#endif
+    }
+
+    // Callers hold io_mutex_.
+    bool open_next_segment() {
+        int next = open_segment(segment_path(segment_ + 1));
+        if (next < 0) return false;
+        close_segment(fd_);
+        fd_ = next;
+        segment_bytes_ = 0;
+        segment_.fetch_add(1);
+        return true;
+    }
+
+    // A failed group must not stay in the middle of the segment, where replay would stop at it and
+    // drop every group after it, so the segment is cut back to its last good group; if that fails,
+    // later groups go to a fresh segment instead.
+    void discard_failed_group() {
+        if (truncate_segment(fd_, segment_bytes_)) return;
+        if (!open_next_segment()) {
+            LOG_ERROR("Failed to cut back or replace " + segment_path(segment_) + " after a failed commit");
+        }
+    }
+
+    void write_group(const std::vector<u8>& group) {
+        size_t written = 0;
+        while (written < group.size()) {
+#ifdef _WIN32
+            int result = ::_write(fd_, group.data() + written, static_cast<unsigned>(group.size() - written));
+#else
+            ssize_t result = ::write(fd_, group.data() + written, group.size() - written);
+#endif
+            if (result < 0 && errno == EINTR) continue;
+            if (result <= 0) {
+                throw std::runtime_error("Failed to append to " + segment_path(segment_));
+            }
+            written += static_cast<size_t>(result);
+        }
+#ifdef _WIN32
+        int synced = ::_commit(fd_);
+#else
+        int synced;
+        do {
+            synced = ::fdatasync(fd_);
+        } while (synced != 0 && errno == EINTR);
+#endif
+        if (synced != 0) {
+            throw std::runtime_error("Failed to sync " + segment_path(segment_));
+        }
+    }
+
+    // Callers hold io_mutex_, so groups reach the segment in record order. A group that fails is
+    // put back at the front of pending_ and retried with the next commit.
+    bool commit_pending() {
+        std::vector<u8> records;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            records.swap(pending_);
+        }
+        if (records.empty() || fd_ < 0) return true;
+
+        std::vector<u8> group(GROUP_HEADER_SIZE);
+        u8* header = put_u32(group.data(), GROUP_MAGIC);
+        header = put_u32(header, static_cast<u32>(records.size()));
+        put_u32(header, static_cast<u32>(crc32(0, records.data(), static_cast<uInt>(records.size()))));
+        group.insert(group.end(), records.begin(), records.end());
+
+        bool committed = true;
+        try {
+            write_group(group);
+            segment_bytes_ += group.size();
+            groups_.fetch_add(1, std::memory_order_relaxed);
+            bytes_.fetch_add(group.size(), std::memory_order_relaxed);
+        } catch (const std::exception& e) {
+            LOG_ERROR(std::string("Block log commit failed, will retry: ") + e.what());
+            failed_commits_.fetch_add(1, std::memory_order_relaxed);
+            discard_failed_group();
+            committed = false;
+        }
+        degraded_.store(!committed, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        failing_ = !committed;
+        if (!committed) pending_.insert(pending_.begin(), records.begin(), records.end());
+        return committed;
+    }
+
+    // While commits are failing, a full pending_ waits for the interval instead of retrying in a
+    // tight loop.
+    void flush_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (running_) {
+            flush_cv_.wait_for(lock, commit_interval_, [this] {
+                return !running_ || (!failing_ && pending_.size() >= MAX_GROUP_BYTES);
+            });
+            lock.unlock();
+            {
+                std::lock_guard<std::mutex> io_lock(io_mutex_);
+                commit_pending();
+            }
+            lock.lock();
+        }
+        lock.unlock();
+        std::lock_guard<std::mutex> io_lock(io_mutex_);
+        commit_pending();
+    }
+
+    void append(const u8* record, size_t size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) return;
+        pending_.insert(pending_.end(), record, record + size);
+        records_.fetch_add(1, std::memory_order_relaxed);
+        if (pending_.size() >= MAX_GROUP_BYTES) {
+            flush_cv_.notify_one();
+        }
+    }
+
+    // Region writes are only synced per commit when sync_region_writes is set, so the segments are
+    // the sole durable copy of their edits until the regions are forced to disk here.
+    bool finish_checkpoint(WorldPersistence& persistence, u64 segment, const SnapshotSaveReport& report) {
+        if (report.failed != 0 || !persistence.background_saves_settled()) {
+            LOG_WARN("Keeping block log segments before " + std::to_string(segment) + ": " +
+                     std::to_string(report.failed) + " chunk saves failed or evictions still pending");
+            return false;
+        }
+        if (!persistence.sync_region_files()) {
+            LOG_WARN("Keeping block log segments before " + std::to_string(segment) + ": region data could not be synced");
+            return false;
+        }
+        truncate_before(segment);
+        return true;
+    }
+
+    // A chunk that fails to load stops the replay, leaving the segment in place, rather than
+    // dropping its edits.
+    static ChunkPtr load_for_replay(ChunkManager& chunks, const Position& pos, const std::string& path) {
+        ChunkPtr chunk = chunks.load_chunk_async(ChunkPos(pos.x >> 4, pos.z >> 4)).get();
+        if (!chunk) {
+            throw std::runtime_error("Chunk " + std::to_string(pos.x >> 4) + ", " + std::to_string(pos.z >> 4) +
+                                     " could not be loaded to replay " + path);
+        }
+        return chunk;
+    }
+
+    size_t replay_segment(const std::string& path, ChunkManager& chunks) {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<u8> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        size_t applied = 0;
+        size_t offset = 0;
+
+        while (offset + GROUP_HEADER_SIZE <= data.size()) {
+            const u8* header = data.data() + offset;
+            u32 size = get_u32(header + 4);
+            if (get_u32(header) != GROUP_MAGIC || size > data.size() - offset - GROUP_HEADER_SIZE) break;
+            const u8* payload = header + GROUP_HEADER_SIZE;
+            if (static_cast<u32>(crc32(0, payload, size)) != get_u32(header + 8)) break;
+
+            for (size_t pos = 0; pos < size;) {
+                u8 type = payload[pos];
+                if (type == RECORD_SET && pos + SET_RECORD_SIZE <= size) {
+                    Position target = get_position(payload + pos + 1);
+                    Block block(static_cast<BlockId>((payload[pos + 13] << 8) | payload[pos + 14]));
+                    ChunkPtr chunk = load_for_replay(chunks, target, path);
+                    chunk->set_block(target.x & 15, target.y, target.z & 15, block);
+                    pos += SET_RECORD_SIZE;
+                } else if (type == RECORD_FILL && pos + FILL_RECORD_SIZE <= size) {
+                    Position from = get_position(payload + pos + 1);
+                    Position to = get_position(payload + pos + 13);
+                    Block block(static_cast<BlockId>((payload[pos + 25] << 8) | payload[pos + 26]));
+                    ChunkPtr chunk = load_for_replay(chunks, from, path);
+                    i32 base_x = (from.x >> 4) * CHUNK_SIZE;
+                    i32 base_z = (from.z >> 4) * CHUNK_SIZE;
+                    chunk->fill(from.x - base_x, from.y, from.z - base_z, to.x - base_x, to.y, to.z - base_z, block);
+                    pos += FILL_RECORD_SIZE;
+                } else {
+                    throw std::runtime_error("Corrupt record in " + path);
+                }
+                applied++;
+            }
+            offset += GROUP_HEADER_SIZE + size;
+        }
+
+        if (offset != data.size()) {
+            LOG_WARN("Discarded " + std::to_string(data.size() - offset) + " bytes of torn block log tail in " + path);
+        }
+        return applied;
+    }
+
+public:
+    BlockChangeLog() = default;
+
+    ~BlockChangeLog() {
+        close();
+    }
+
+    BlockChangeLog(const BlockChangeLog&) = delete;
+    BlockChangeLog& operator=(const BlockChangeLog&) = delete;
+
+    void open(const std::string& directory) {
+        close();
+        directory_ = directory;
+        std::filesystem::create_directories(directory_);
+        auto segments = list_segments();
+        segment_.store(segments.empty() ? 1 : segments.back() + 1);
+        fd_ = open_segment(segment_path(segment_));
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open " + segment_path(segment_));
+        }
+        segment_bytes_ = 0;
+        degraded_.store(false);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = true;
+        flusher_ = std::thread(&BlockChangeLog::flush_loop, this);
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) return;
+            running_ = false;
+        }
+        flush_cv_.notify_one();
+        if (flusher_.joinable()) flusher_.join();
+
+        std::lock_guard<std::mutex> io_lock(io_mutex_);
+        if (fd_ >= 0) {
+            close_segment(fd_);
+            fd_ = -1;
+        }
+    }
+
+    void set_commit_interval(std::chrono::milliseconds interval) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        commit_interval_ = std::max(interval, std::chrono::milliseconds(1));
+    }
+
+    void record_set(const Position& pos, BlockId id) override {
+        u8 record[SET_RECORD_SIZE] = {RECORD_SET};
+        put_block(put_position(record + 1, pos), id);
+        append(record, sizeof(record));
+    }
+
+    void record_fill(const Position& from, const Position& to, BlockId id) override {
+        u8 record[FILL_RECORD_SIZE] = {RECORD_FILL};
+        put_block(put_position(put_position(record + 1, from), to), id);
+        append(record, sizeof(record));
+    }
+
+    // Returns false when the pending records could not be made durable; they stay queued.
+    bool commit() {
+        std::lock_guard<std::mutex> io_lock(io_mutex_);
+        return commit_pending();
+    }
+
+    u64 rotate() {
+        std::lock_guard<std::mutex> io_lock(io_mutex_);
+        commit_pending();
+        if (fd_ < 0) return segment_;
+        if (!open_next_segment()) {
+            LOG_ERROR("Failed to open " + segment_path(segment_ + 1) + ", continuing in current segment");
+        }
+        return segment_;
+    }
+
+    size_t truncate_before(u64 segment) {
+        std::lock_guard<std::mutex> io_lock(io_mutex_);
+        size_t removed = 0;
+        for (u64 old : list_segments()) {
+            if (old >= std::min(segment, segment_.load())) continue;
+            std::error_code error;
+            if (std::filesystem::remove(segment_path(old), error)) removed++;
+        }
+        return removed;
+    }
+
+    size_t replay(ChunkManager& chunks) {
+        size_t applied = 0;
+        for (u64 segment : list_segments()) {
+            if (segment >= segment_) continue;
+            applied += replay_segment(segment_path(segment), chunks);
+        }
+        replayed_.fetch_add(applied, std::memory_order_relaxed);
+        return applied;
+    }
+
+    // Edits are applied before they are logged, so rotating first guarantees every record in an
+    // older segment is already reflected in the dirty chunks snapshotted here.
+    bool checkpoint(ChunkManager& chunks, WorldPersistence& persistence) {
+        u64 segment = rotate();
+        SnapshotSaveReport report = persistence.save_snapshots(chunks.snapshot_dirty_chunks());
+        return finish_checkpoint(persistence, segment, report);
+    }
+
+    void checkpoint_async(ChunkManager& chunks, WorldPersistence& persistence, SnapshotSaveCallback on_complete = nullptr) {
+        u64 segment = rotate();
+        persistence.save_snapshots_async(chunks.snapshot_dirty_chunks(),
+            [this, &persistence, segment, on_complete = std::move(on_complete)](const SnapshotSaveReport& report) {
+                finish_checkpoint(persistence, segment, report);
+                if (on_complete) on_complete(report);
+            });
+    }
+
+    u64 current_segment() const {
+        return segment_.load();
+    }
+
+    BlockLogStats get_stats() const {
+        BlockLogStats stats;
+        stats.records = records_.load(std::memory_order_relaxed);
+        stats.groups = groups_.load(std::memory_order_relaxed);
+        stats.bytes = bytes_.load(std::memory_order_relaxed);
+        stats.replayed = replayed_.load(std::memory_order_relaxed);
+        stats.segment = segment_.load();
+        stats.failed_commits = failed_commits_.load(std::memory_order_relaxed);
+        stats.degraded = degraded_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    // True while the latest commit failed: logged edits are queued but not yet durable.
+    bool is_degraded() const {
+        return degraded_.load(std::memory_order_relaxed);
+    }
+};
+
+extern BlockChangeLog g_block_change_log;
+
+}
@@ -6,51 +6,167 @@
 #include <memory>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
 #include <unordered_map>
 #include <unordered_set>
 #include <functional>
+#include <future>
 #include <vector>
 #include <chrono>
+#include <cmath>
+#include <limits>
 
 namespace mc::world {
 
+using mc::ChunkPos;
+
 constexpr i32 SECTIONS_PER_CHUNK = (WORLD_MAX_Y - WORLD_MIN_Y) / 16;
 
-class Chunk {
+struct ChunkPosHash {
+    size_t operator()(const ChunkPos& pos) const {
+        u64 key = (static_cast<u64>(static_cast<u32>(pos.x)) << 32) | static_cast<u32>(pos.z);
+        key ^= key >> 33;
+        key *= 0xFF51AFD7ED558CCDull;
+        key ^= key >> 33;
+        key *= 0xC4CEB9FE1A85EC53ull;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+};
+
+struct BlockChange {
+    Position position;
+    Block block;
+};
+
+class BlockChangeSet {
+public:
+    static constexpr i32 SECTION_RESEND_THRESHOLD = 512;
+
+    struct ChunkChanges {
+        std::vector<BlockChange> changes;
+        u32 resent_sections = 0;
+    };
+
+private:
+    std::unordered_map<ChunkPos, ChunkChanges, ChunkPosHash> chunks_;
+
+public:
+    void record(const ChunkPos& chunk, const Position& position, const Block& block) {
+        chunks_[chunk].changes.push_back({position, block});
+    }
+
+    void mark_section(const ChunkPos& chunk, i32 section_idx) {
+        chunks_[chunk].resent_sections |= u32(1) << section_idx;
+    }
+
+    void merge(BlockChangeSet&& other) {
+        for (auto& [pos, changes] : other.chunks_) {
+            auto& target = chunks_[pos];
+            target.resent_sections |= changes.resent_sections;
+            target.changes.insert(target.changes.end(), changes.changes.begin(), changes.changes.end());
+        }
+        other.chunks_.clear();
+    }
+
+    bool empty() const { return chunks_.empty(); }
+    const std::unordered_map<ChunkPos, ChunkChanges, ChunkPosHash>& chunks() const { return chunks_; }
+};
+
+struct BlockVolume {
+    i32 size_x;
+    i32 size_y;
+    i32 size_z;
+    std::vector<BlockId> blocks;
+
+    BlockVolume(i32 x, i32 y, i32 z, BlockId fill = AIR)
+        : size_x(x), size_y(y), size_z(z)
+        , blocks(static_cast<size_t>(x) * y * z, fill) {}
+
+    size_t index_of(i32 x, i32 y, i32 z) const {
+        return (static_cast<size_t>(y) * size_z + z) * size_x + x;
+    }
+
+    BlockId get(i32 x, i32 y, i32 z) const { return blocks[index_of(x, y, z)]; }
+    void set(i32 x, i32 y, i32 z, BlockId id) { blocks[index_of(x, y, z)] = id; }
+};
+
+class Chunk : public std::enable_shared_from_this<Chunk> {
+public:
+    static constexpr u32 ALL_SECTIONS = (u32(1) << SECTIONS_PER_CHUNK) - 1;
+
 private:
     ChunkPos position_;
-    std::array<std::unique_ptr<ChunkSection>, SECTIONS_PER_CHUNK> sections_;
+    std::array<std::atomic<ChunkSection*>, SECTIONS_PER_CHUNK> sections_{};
     std::atomic<bool> loaded_{false};
-    std::atomic<bool> dirty_{false};
-    std::chrono::steady_clock::time_point last_access_;
-    mutable std::mutex access_mutex_;
-    std::mutex sections_mutex_;
+    std::atomic<u64> version_{0};
+    std::atomic<u64> saved_version_{0};
+    std::atomic<bool> referenced_{true};
+    std::atomic<std::chrono::steady_clock::rep> last_access_;
+    mutable std::mutex sections_mutex_;
+    u32 modified_sections_ = ALL_SECTIONS;
+
+    static constexpr auto TOUCH_GRANULARITY = std::chrono::milliseconds(100);
 
     i32 get_section_index(i32 y) const {
         return (y - WORLD_MIN_Y) / 16;
     }
 
+    bool has_section(i32 section_idx) const {
+        return section_idx >= 0 && section_idx < SECTIONS_PER_CHUNK &&
+               sections_[section_idx].load(std::memory_order_relaxed);
+    }
+
+    Position world_position(i32 x, i32 y, i32 z) const {
+        return Position(position_.x * CHUNK_SIZE + x, y, position_.z * CHUNK_SIZE + z);
+    }
+
+    const ChunkSection* find_section(i32 section_idx) const {
+        if (section_idx < 0 || section_idx >= SECTIONS_PER_CHUNK) return nullptr;
+        return sections_[section_idx].load(std::memory_order_acquire);
+    }
+
     ChunkSection* get_or_create_section(i32 section_idx) {
         if (section_idx < 0 || section_idx >= SECTIONS_PER_CHUNK) return nullptr;
-        if (!sections_[section_idx]) {
-            sections_[section_idx] = std::make_unique<ChunkSection>();
+        modified_sections_ |= u32(1) << section_idx;
+        ChunkSection* section = sections_[section_idx].load(std::memory_order_relaxed);
+        if (!section) {
+            section = new ChunkSection();
+            sections_[section_idx].store(section, std::memory_order_release);
+        } else if (section->is_shared()) {
+            ChunkSection* copy = section->clone().release();
+            sections_[section_idx].store(copy, std::memory_order_release);
+            ChunkSection::release(section);
+            section = copy;
         }
-        return sections_[section_idx].get();
+        return section;
+    }
+
+    void mark_modified() {
+        version_.fetch_add(1, std::memory_order_acq_rel);
     }
 
 public:
     explicit Chunk(const ChunkPos& pos)
         : position_(pos)
-        , last_access_(std::chrono::steady_clock::now()) {
+        , last_access_(std::chrono::steady_clock::now().time_since_epoch().count()) {
+    }
+
+    ~Chunk() {
+        for (auto& section : sections_) {
+            delete section.load(std::memory_order_relaxed);
+        }
     }
 
+    Chunk(const Chunk&) = delete;
+    Chunk& operator=(const Chunk&) = delete;
+
     const ChunkPos& get_position() const { return position_; }
 
     Block get_block(i32 x, i32 y, i32 z) const {
-        std::lock_guard<std::mutex> lock(sections_mutex_);
+        EpochGuard guard;
         i32 section_idx = get_section_index(y);
-        if (section_idx < 0 || section_idx >= SECTIONS_PER_CHUNK) return Block();
-        const auto& section = sections_[section_idx];
+        const ChunkSection* section = find_section(section_idx);
         if (!section) return Block();
         i32 local_y = y - (section_idx * 16 + WORLD_MIN_Y);
         return section->get_block(x, local_y, z);
@@ -59,22 +175,19 @@ public:
     void set_block(i32 x, i32 y, i32 z, const Block& block) {
         std::lock_guard<std::mutex> lock(sections_mutex_);
         i32 section_idx = get_section_index(y);
+        if (block.is_air() && !has_section(section_idx)) return;
         ChunkSection* section = get_or_create_section(section_idx);
         if (!section) return;
         i32 local_y = y - (section_idx * 16 + WORLD_MIN_Y);
         section->set_block(x, local_y, z, block);
-        dirty_.store(true);
-        {
-            std::lock_guard<std::mutex> al(access_mutex_);
-            last_access_ = std::chrono::steady_clock::now();
-        }
+        mark_modified();
+        touch();
     }
 
     u8 get_block_light(i32 x, i32 y, i32 z) const {
-        std::lock_guard<std::mutex> lock(sections_mutex_);
+        EpochGuard guard;
         i32 section_idx = get_section_index(y);
-        if (section_idx < 0 || section_idx >= SECTIONS_PER_CHUNK) return 0;
-        const auto& section = sections_[section_idx];
+        const ChunkSection* section = find_section(section_idx);
         if (!section) return 0;
         i32 local_y = y - (section_idx * 16 + WORLD_MIN_Y);
         return section->get_block_light(x, local_y, z);
@@ -83,18 +196,19 @@ public:
     void set_block_light(i32 x, i32 y, i32 z, u8 light) {
         std::lock_guard<std::mutex> lock(sections_mutex_);
         i32 section_idx = get_section_index(y);
+        if (light == 0 && !has_section(section_idx)) return;
         ChunkSection* section = get_or_create_section(section_idx);
         if (!section) return;
         i32 local_y = y - (section_idx * 16 + WORLD_MIN_Y);
         section->set_block_light(x, local_y, z, light);
-        dirty_.store(true);
+        mark_modified();
     }
 
     u8 get_sky_light(i32 x, i32 y, i32 z) const {
-        std::lock_guard<std::mutex> lock(sections_mutex_);
+        EpochGuard guard;
         i32 section_idx = get_section_index(y);
         if (section_idx < 0 || section_idx >= SECTIONS_PER_CHUNK) return 0;
-        const auto& section = sections_[section_idx];
+        const ChunkSection* section = find_section(section_idx);
         if (!section) return 15;
         i32 local_y = y - (section_idx * 16 + WORLD_MIN_Y);
         return section->get_sky_light(x, local_y, z);
@@ -103,157 +217,1046 @@ public:
     void set_sky_light(i32 x, i32 y, i32 z, u8 light) {
         std::lock_guard<std::mutex> lock(sections_mutex_);
         i32 section_idx = get_section_index(y);
+        if (light == 15 && !has_section(section_idx)) return;
         ChunkSection* section = get_or_create_section(section_idx);
         if (!section) return;
         i32 local_y = y - (section_idx * 16 + WORLD_MIN_Y);
         section->set_sky_light(x, local_y, z, light);
-        dirty_.store(true);
+        mark_modified();
+    }
+
+    void fill(i32 x0, i32 y0, i32 z0, i32 x1, i32 y1, i32 z1, const Block& block,
+              BlockChangeSet* changes = nullptr) {
+        if (x0 > x1) std::swap(x0, x1);
+        if (y0 > y1) std::swap(y0, y1);
+        if (z0 > z1) std::swap(z0, z1);
+        x0 = std::max(x0, 0);
+        x1 = std::min(x1, CHUNK_SIZE - 1);
+        z0 = std::max(z0, 0);
+        z1 = std::min(z1, CHUNK_SIZE - 1);
+        y0 = std::max(y0, WORLD_MIN_Y);
+        y1 = std::min(y1, WORLD_MAX_Y - 1);
+        if (x0 > x1 || z0 > z1 || y0 > y1) return;
+
+        std::lock_guard<std::mutex> lock(sections_mutex_);
+        for (i32 section_idx = get_section_index(y0); section_idx <= get_section_index(y1); ++section_idx) {
+            if (block.is_air() && !has_section(section_idx)) continue;
+            ChunkSection* section = get_or_create_section(section_idx);
+            i32 base_y = section_idx * 16 + WORLD_MIN_Y;
+            i32 ly0 = std::max(y0 - base_y, 0);
+            i32 ly1 = std::min(y1 - base_y, 15);
+
+            if (changes) {
+                i32 volume = (x1 - x0 + 1) * (z1 - z0 + 1) * (ly1 - ly0 + 1);
+                if (volume >= BlockChangeSet::SECTION_RESEND_THRESHOLD) {
+                    changes->mark_section(position_, section_idx);
+                } else {
+                    for (i32 y = ly0; y <= ly1; ++y)
+                        for (i32 z = z0; z <= z1; ++z)
+                            for (i32 x = x0; x <= x1; ++x)
+                                if (section->get_block(x, y, z).id != block.id)
+                                    changes->record(position_, world_position(x, base_y + y, z), block);
+                }
+            }
+
+            if (x0 == 0 && x1 == CHUNK_SIZE - 1 && z0 == 0 && z1 == CHUNK_SIZE - 1) {
+                section->fill_range(ChunkSection::index_of(0, ly0, 0), ChunkSection::index_of(0, ly1 + 1, 0), block);
+            } else if (x0 == 0 && x1 == CHUNK_SIZE - 1) {
+                for (i32 y = ly0; y <= ly1; ++y) {
+                    section->fill_range(ChunkSection::index_of(0, y, z0), ChunkSection::index_of(0, y, z1 + 1), block);
+                }
+            } else {
+                for (i32 y = ly0; y <= ly1; ++y) {
+                    for (i32 z = z0; z <= z1; ++z) {
+                        section->fill_range(ChunkSection::index_of(x0, y, z), ChunkSection::index_of(x1 + 1, y, z), block);
+                    }
+                }
+            }
+        }
+        mark_modified();
+        touch();
+    }
+
+    void set_blocks(const std::vector<BlockChange>& edits, BlockChangeSet* changes = nullptr) {
+        if (edits.empty()) return;
+        std::lock_guard<std::mutex> lock(sections_mutex_);
+        i32 cached_idx = -1;
+        ChunkSection* section = nullptr;
+        for (const auto& edit : edits) {
+            i32 section_idx = get_section_index(edit.position.y);
+            if (section_idx < 0 || section_idx >= SECTIONS_PER_CHUNK) continue;
+            if (section_idx != cached_idx) {
+                cached_idx = section_idx;
+                section = has_section(section_idx) ? get_or_create_section(section_idx) : nullptr;
+            }
+            if (!section) {
+                if (edit.block.is_air()) continue;
+                section = get_or_create_section(section_idx);
+            }
+            i32 local_y = edit.position.y - (section_idx * 16 + WORLD_MIN_Y);
+            Block old_block = section->set_block(edit.position.x & 15, local_y, edit.position.z & 15, edit.block);
+            if (changes && old_block.id != edit.block.id) {
+                changes->record(position_, world_position(edit.position.x & 15, edit.position.y, edit.position.z & 15), edit.block);
+            }
+        }
+        mark_modified();
+        touch();
+    }
+
+    void copy_blocks(const BlockVolume& volume, const Position& origin, BlockChangeSet* changes = nullptr) {
+        i32 base_x = position_.x * CHUNK_SIZE;
+        i32 base_z = position_.z * CHUNK_SIZE;
+        i32 x0 = std::max(origin.x, base_x), x1 = std::min(origin.x + volume.size_x, base_x + CHUNK_SIZE);
+        i32 z0 = std::max(origin.z, base_z), z1 = std::min(origin.z + volume.size_z, base_z + CHUNK_SIZE);
+        i32 y0 = std::max(origin.y, WORLD_MIN_Y), y1 = std::min(origin.y + volume.size_y, WORLD_MAX_Y);
+        if (x0 >= x1 || z0 >= z1 || y0 >= y1) return;
+
+        std::lock_guard<std::mutex> lock(sections_mutex_);
+        for (i32 section_idx = get_section_index(y0); section_idx <= get_section_index(y1 - 1); ++section_idx) {
+            ChunkSection* section = get_or_create_section(section_idx);
+            i32 base_y = section_idx * 16 + WORLD_MIN_Y;
+            i32 ly0 = std::max(y0 - base_y, 0);
+            i32 ly1 = std::min(y1 - base_y, 16);
+            bool resend = changes &&
+                (x1 - x0) * (z1 - z0) * (ly1 - ly0) >= BlockChangeSet::SECTION_RESEND_THRESHOLD;
+            if (resend) changes->mark_section(position_, section_idx);
+
+            for (i32 y = ly0; y < ly1; ++y) {
+                for (i32 z = z0; z < z1; ++z) {
+                    const BlockId* row = &volume.blocks[volume.index_of(x0 - origin.x, base_y + y - origin.y, z - origin.z)];
+                    for (i32 x = x0; x < x1; ++x) {
+                        Block block(row[x - x0]);
+                        Block old_block = section->set_block(x - base_x, y, z - base_z, block);
+                        if (changes && !resend && old_block.id != block.id) {
+                            changes->record(position_, Position(x, base_y + y, z), block);
+                        }
+                    }
+                }
+            }
+        }
+        mark_modified();
+        touch();
     }
 
     bool is_loaded() const { return loaded_.load(); }
     void set_loaded(bool loaded) { loaded_.store(loaded); }
 
-    bool is_dirty() const { return dirty_.load(); }
-    void set_dirty(bool dirty) { dirty_.store(dirty); }
+    bool is_dirty() const {
+        return version_.load(std::memory_order_acquire) != saved_version_.load(std::memory_order_acquire);
+    }
+
+    void set_dirty(bool dirty) {
+        if (dirty) {
+            mark_modified();
+        } else {
+            mark_saved(version_.load(std::memory_order_acquire));
+        }
+    }
+
+    u64 get_version() const { return version_.load(std::memory_order_acquire); }
+    u64 get_saved_version() const { return saved_version_.load(std::memory_order_acquire); }
+
+    void mark_saved(u64 version) {
+        u64 saved = saved_version_.load(std::memory_order_relaxed);
+        while (saved < version &&
+               !saved_version_.compare_exchange_weak(saved, version, std::memory_order_acq_rel)) {}
+    }
+
+    u64 pin_sections(std::array<const ChunkSection*, SECTIONS_PER_CHUNK>& out, u32& modified_sections) const {
+        std::lock_guard<std::mutex> lock(sections_mutex_);
+        for (i32 i = 0; i < SECTIONS_PER_CHUNK; ++i) {
+            const ChunkSection* section = sections_[i].load(std::memory_order_relaxed);
+            if (section) section->pin();
+            out[i] = section;
+        }
+        modified_sections = modified_sections_;
+        return version_.load(std::memory_order_relaxed);
+    }
+
+    // Sections that may differ from generate_flat_world(); ALL_SECTIONS for chunks that did not
+    // come from the generator.
+    u32 get_modified_sections() const {
+        std::lock_guard<std::mutex> lock(sections_mutex_);
+        return modified_sections_;
+    }
 
     std::chrono::steady_clock::time_point get_last_access() const {
-        std::lock_guard<std::mutex> al(access_mutex_);
-        return last_access_;
+        return std::chrono::steady_clock::time_point(
+            std::chrono::steady_clock::duration(last_access_.load(std::memory_order_relaxed)));
+    }
+
+    void mark_referenced() {
+        if (!referenced_.load(std::memory_order_relaxed)) {
+            referenced_.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    bool take_referenced() {
+        return referenced_.load(std::memory_order_relaxed) &&
+               referenced_.exchange(false, std::memory_order_relaxed);
     }
 
     void touch() {
-        std::lock_guard<std::mutex> al(access_mutex_);
-        last_access_ = std::chrono::steady_clock::now();
+        mark_referenced();
+        auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+        auto last = last_access_.load(std::memory_order_relaxed);
+        if (now - last >= std::chrono::steady_clock::duration(TOUCH_GRANULARITY).count()) {
+            last_access_.store(now, std::memory_order_relaxed);
+        }
     }
 
     std::vector<const ChunkSection*> get_sections() const {
-        std::lock_guard<std::mutex> lock(sections_mutex_);
         std::vector<const ChunkSection*> result;
         result.reserve(SECTIONS_PER_CHUNK);
         for (const auto& section : sections_) {
-            result.push_back(section.get());
+            result.push_back(section.load(std::memory_order_acquire));
         }
         return result;
     }
 
-    void generate_flat_world() {
+    size_t memory_usage() const {
+        EpochGuard guard;
+        size_t total = sizeof(*this);
+        for (const auto& section : sections_) {
+            const ChunkSection* current = section.load(std::memory_order_acquire);
+            if (current) total += current->memory_usage();
+        }
+        return total;
+    }
+
+    void set_section(i32 section_idx, std::unique_ptr<ChunkSection> section) {
+        if (section_idx < 0 || section_idx >= SECTIONS_PER_CHUNK) return;
         std::lock_guard<std::mutex> lock(sections_mutex_);
-        for (i32 x = 0; x < CHUNK_SIZE; ++x) {
-            for (i32 z = 0; z < CHUNK_SIZE; ++z) {
-                set_block(x, WORLD_MIN_Y, z, Block(BEDROCK));
-                for (i32 y = WORLD_MIN_Y + 1; y <= 60; ++y) {
-                    set_block(x, y, z, Block(STONE));
-                }
-                for (i32 y = 61; y <= 63; ++y) {
-                    set_block(x, y, z, Block(DIRT));
-                }
-                set_block(x, 64, z, Block(GRASS_BLOCK));
-            }
+        modified_sections_ |= u32(1) << section_idx;
+        ChunkSection::release(sections_[section_idx].exchange(section.release(), std::memory_order_acq_rel));
+    }
+
+    void generate_flat_world() {
+        constexpr i32 max = CHUNK_SIZE - 1;
+        fill(0, WORLD_MIN_Y, 0, max, WORLD_MIN_Y, max, Block(BEDROCK));
+        fill(0, WORLD_MIN_Y + 1, 0, max, 60, max, Block(STONE));
+        fill(0, 61, 0, max, 63, max, Block(DIRT));
+        fill(0, 64, 0, max, 64, max, Block(GRASS_BLOCK));
+        {
+            std::lock_guard<std::mutex> lock(sections_mutex_);
+            modified_sections_ = 0;
         }
         loaded_.store(true);
-        dirty_.store(true);
+        mark_modified();
     }
 };
 
 using ChunkPtr = std::shared_ptr<Chunk>;
+using ChunkCallback = std::function<void(const ChunkPtr&)>;
 
-struct ChunkPosHash {
-    size_t operator()(const ChunkPos& pos) const {
-        return std::hash<i64>{}((static_cast<i64>(pos.x) << 32) ^ static_cast<i64>(static_cast<u32>(pos.z)));
+class ChunkSnapshot {
+private:
+    ChunkPtr chunk_;
+    u64 version_ = 0;
+    u32 modified_sections_ = Chunk::ALL_SECTIONS;
+    std::array<const ChunkSection*, SECTIONS_PER_CHUNK> sections_{};
+
+    void release() {
+        for (auto& section : sections_) {
+            ChunkSection::release(section);
+            section = nullptr;
+        }
+    }
+
+public:
+    ChunkSnapshot() = default;
+
+    explicit ChunkSnapshot(ChunkPtr chunk) : chunk_(std::move(chunk)) {
+        if (chunk_) version_ = chunk_->pin_sections(sections_, modified_sections_);
+    }
+
+    ~ChunkSnapshot() { release(); }
+
+    ChunkSnapshot(ChunkSnapshot&& other) noexcept
+        : chunk_(std::move(other.chunk_)), version_(other.version_),
+          modified_sections_(other.modified_sections_), sections_(other.sections_) {
+        other.sections_.fill(nullptr);
+    }
+
+    ChunkSnapshot& operator=(ChunkSnapshot&& other) noexcept {
+        if (this != &other) {
+            release();
+            chunk_ = std::move(other.chunk_);
+            version_ = other.version_;
+            modified_sections_ = other.modified_sections_;
+            sections_ = other.sections_;
+            other.sections_.fill(nullptr);
+        }
+        return *this;
+    }
+
+    ChunkSnapshot(const ChunkSnapshot&) = delete;
+    ChunkSnapshot& operator=(const ChunkSnapshot&) = delete;
+
+    const ChunkPtr& chunk() const { return chunk_; }
+    const ChunkPos& get_position() const { return chunk_->get_position(); }
+    u64 get_version() const { return version_; }
+    u32 get_modified_sections() const { return modified_sections_; }
+    const std::array<const ChunkSection*, SECTIONS_PER_CHUNK>& get_sections() const { return sections_; }
+
+    void mark_saved() const { chunk_->mark_saved(version_); }
+};
+
+class ChunkStorage {
+public:
+    virtual ~ChunkStorage() = default;
+    virtual ChunkPtr read_chunk(const ChunkPos& pos) = 0;
+    // on_done runs once the save has finished, whether or not it succeeded.
+    virtual void save_chunk_in_background(ChunkPtr chunk, std::function<void()> on_done = nullptr) = 0;
+};
+
+class BlockChangeJournal {
+public:
+    virtual ~BlockChangeJournal() = default;
+    virtual void record_set(const Position& pos, BlockId id) = 0;
+    virtual void record_fill(const Position& from, const Position& to, BlockId id) = 0;
+};
+
+class ChunkIndex {
+private:
+    struct Slot {
+        std::atomic<u64> key{0};
+        std::atomic<Chunk*> chunk{nullptr};
+        std::atomic<bool> used{false};
+    };
+
+    struct Table {
+        size_t capacity;
+        size_t used = 0;
+        size_t live = 0;
+        std::unique_ptr<Slot[]> slots;
+
+        explicit Table(size_t table_capacity)
+            : capacity(table_capacity), slots(std::make_unique<Slot[]>(table_capacity)) {}
+    };
+
+    static constexpr size_t INITIAL_CAPACITY = 64;
+
+    std::atomic<Table*> table_;
+
+    static u64 make_key(const ChunkPos& pos) {
+        return (static_cast<u64>(static_cast<u32>(pos.x)) << 32) | static_cast<u32>(pos.z);
+    }
+
+    static size_t slot_for(u64 key, size_t capacity) {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (capacity - 1);
+    }
+
+    static Slot* probe(Table* table, u64 key) {
+        size_t i = slot_for(key, table->capacity);
+        while (true) {
+            Slot& slot = table->slots[i];
+            if (!slot.used.load(std::memory_order_relaxed) ||
+                slot.key.load(std::memory_order_relaxed) == key) {
+                return &slot;
+            }
+            i = (i + 1) & (table->capacity - 1);
+        }
+    }
+
+    void rebuild(size_t capacity) {
+        Table* old = table_.load(std::memory_order_relaxed);
+        auto table = std::make_unique<Table>(capacity);
+        for (size_t i = 0; i < old->capacity; ++i) {
+            Chunk* chunk = old->slots[i].chunk.load(std::memory_order_relaxed);
+            if (!chunk) continue;
+            u64 key = old->slots[i].key.load(std::memory_order_relaxed);
+            Slot* slot = probe(table.get(), key);
+            slot->key.store(key, std::memory_order_relaxed);
+            slot->chunk.store(chunk, std::memory_order_relaxed);
+            slot->used.store(true, std::memory_order_relaxed);
+            table->used++;
+            table->live++;
+        }
+        table_.store(table.release(), std::memory_order_release);
+        g_epoch_manager.retire(old);
+    }
+
+public:
+    ChunkIndex() : table_(new Table(INITIAL_CAPACITY)) {}
+
+    ~ChunkIndex() {
+        delete table_.load(std::memory_order_relaxed);
+    }
+
+    ChunkIndex(const ChunkIndex&) = delete;
+    ChunkIndex& operator=(const ChunkIndex&) = delete;
+
+    Chunk* find(const ChunkPos& pos) const {
+        const Table* table = table_.load(std::memory_order_acquire);
+        u64 key = make_key(pos);
+        size_t i = slot_for(key, table->capacity);
+        while (true) {
+            const Slot& slot = table->slots[i];
+            if (!slot.used.load(std::memory_order_acquire)) return nullptr;
+            if (slot.key.load(std::memory_order_relaxed) == key) {
+                return slot.chunk.load(std::memory_order_acquire);
+            }
+            i = (i + 1) & (table->capacity - 1);
+        }
+    }
+
+    void insert(const ChunkPos& pos, Chunk* chunk) {
+        Table* table = table_.load(std::memory_order_relaxed);
+        u64 key = make_key(pos);
+        Slot* slot = probe(table, key);
+        if (slot->used.load(std::memory_order_relaxed)) {
+            if (!slot->chunk.load(std::memory_order_relaxed)) table->live++;
+            slot->chunk.store(chunk, std::memory_order_release);
+            return;
+        }
+        if ((table->used + 1) * 2 > table->capacity) {
+            rebuild(table->live * 4 > table->capacity ? table->capacity * 2 : table->capacity);
+            insert(pos, chunk);
+            return;
+        }
+        slot->key.store(key, std::memory_order_relaxed);
+        slot->chunk.store(chunk, std::memory_order_relaxed);
+        slot->used.store(true, std::memory_order_release);
+        table->used++;
+        table->live++;
+    }
+
+    void erase(const ChunkPos& pos) {
+        Table* table = table_.load(std::memory_order_relaxed);
+        Slot* slot = probe(table, make_key(pos));
+        if (slot->used.load(std::memory_order_relaxed) && slot->chunk.load(std::memory_order_relaxed)) {
+            slot->chunk.store(nullptr, std::memory_order_release);
+            table->live--;
+        }
+    }
+};
+
+class ChunkTable {
+public:
+    static constexpr u32 SHARD_BITS = 6;
+    static constexpr size_t SHARD_COUNT = size_t(1) << SHARD_BITS;
+
+private:
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<ChunkPos, ChunkPtr, ChunkPosHash> chunks;
+        std::unordered_map<ChunkPos, std::vector<ChunkCallback>, ChunkPosHash> pending;
+        ChunkIndex index;
+    };
+
+    std::array<Shard, SHARD_COUNT> shards_;
+    std::atomic<size_t> size_{0};
+    std::atomic<size_t> pending_count_{0};
+
+    Shard& shard_for(const ChunkPos& pos) {
+        return shards_[static_cast<u64>(ChunkPosHash{}(pos)) >> (64 - SHARD_BITS)];
+    }
+
+    const Shard& shard_for(const ChunkPos& pos) const {
+        return shards_[static_cast<u64>(ChunkPosHash{}(pos)) >> (64 - SHARD_BITS)];
+    }
+
+    std::vector<ChunkCallback> take_waiters(Shard& shard, const ChunkPos& pos) {
+        std::vector<ChunkCallback> waiters;
+        auto it = shard.pending.find(pos);
+        if (it == shard.pending.end()) return waiters;
+        waiters = std::move(it->second);
+        shard.pending.erase(it);
+        pending_count_.fetch_sub(1, std::memory_order_relaxed);
+        return waiters;
+    }
+
+public:
+    Chunk* find_raw(const ChunkPos& pos) const {
+        return shard_for(pos).index.find(pos);
+    }
+
+    ChunkPtr find(const ChunkPos& pos) const {
+        EpochGuard guard;
+        Chunk* chunk = find_raw(pos);
+        return chunk ? chunk->shared_from_this() : nullptr;
+    }
+
+    ChunkPtr reserve(const ChunkPos& pos, bool& reserved, ChunkCallback waiter = nullptr) {
+        reserved = false;
+        if (auto chunk = find(pos)) return chunk;
+        Shard& shard = shard_for(pos);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.chunks.find(pos);
+        if (it != shard.chunks.end()) return it->second;
+        auto [pending, inserted] = shard.pending.try_emplace(pos);
+        if (inserted) {
+            pending_count_.fetch_add(1, std::memory_order_relaxed);
+            reserved = true;
+        }
+        if (waiter) pending->second.push_back(std::move(waiter));
+        return nullptr;
+    }
+
+    std::vector<ChunkCallback> publish(const ChunkPos& pos, ChunkPtr chunk) {
+        Shard& shard = shard_for(pos);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        std::vector<ChunkCallback> waiters = take_waiters(shard, pos);
+        auto& slot = shard.chunks[pos];
+        if (slot) {
+            g_epoch_manager.retire(new ChunkPtr(std::move(slot)));
+        } else {
+            size_.fetch_add(1, std::memory_order_relaxed);
+        }
+        slot = std::move(chunk);
+        shard.index.insert(pos, slot.get());
+        return waiters;
+    }
+
+    std::vector<ChunkCallback> cancel(const ChunkPos& pos) {
+        Shard& shard = shard_for(pos);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return take_waiters(shard, pos);
+    }
+
+    ChunkPtr remove(const ChunkPos& pos, const Chunk* expected = nullptr) {
+        Shard& shard = shard_for(pos);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.chunks.find(pos);
+        if (it == shard.chunks.end()) return nullptr;
+        if (expected && it->second.get() != expected) return nullptr;
+        ChunkPtr chunk = std::move(it->second);
+        shard.chunks.erase(it);
+        shard.index.erase(pos);
+        g_epoch_manager.retire(new ChunkPtr(chunk));
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return chunk;
+    }
+
+    template<typename Func>
+    void for_each(Func&& func) const {
+        for (const auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (const auto& [pos, chunk] : shard.chunks) {
+                func(pos, chunk);
+            }
+        }
+    }
+
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+    size_t pending_count() const { return pending_count_.load(std::memory_order_relaxed); }
+};
+
+class ChunkClock {
+private:
+    struct Entry {
+        ChunkPtr chunk;
+        size_t bytes;
+    };
+
+    std::vector<Entry> ring_;
+    std::unordered_map<ChunkPos, size_t, ChunkPosHash> slots_;
+    size_t hand_ = 0;
+    size_t resident_bytes_ = 0;
+
+    void erase_at(size_t slot) {
+        resident_bytes_ -= ring_[slot].bytes;
+        slots_.erase(ring_[slot].chunk->get_position());
+        if (slot != ring_.size() - 1) {
+            ring_[slot] = std::move(ring_.back());
+            slots_[ring_[slot].chunk->get_position()] = slot;
+        }
+        ring_.pop_back();
+    }
+
+public:
+    void insert(const ChunkPtr& chunk) {
+        size_t bytes = chunk->memory_usage();
+        auto it = slots_.find(chunk->get_position());
+        if (it != slots_.end()) {
+            Entry& entry = ring_[it->second];
+            resident_bytes_ = resident_bytes_ - entry.bytes + bytes;
+            entry = {chunk, bytes};
+            return;
+        }
+        slots_[chunk->get_position()] = ring_.size();
+        ring_.push_back({chunk, bytes});
+        resident_bytes_ += bytes;
+    }
+
+    void erase(const ChunkPos& pos) {
+        auto it = slots_.find(pos);
+        if (it != slots_.end()) erase_at(it->second);
+    }
+
+    template<typename IsProtected>
+    std::vector<ChunkPtr> select_victims(size_t budget_bytes, size_t max_chunks, IsProtected&& is_protected) {
+        std::vector<ChunkPtr> victims;
+        size_t steps = 2 * ring_.size();
+        while ((resident_bytes_ > budget_bytes || ring_.size() > max_chunks) && !ring_.empty() && steps-- > 0) {
+            if (hand_ >= ring_.size()) hand_ = 0;
+            Entry& entry = ring_[hand_];
+            size_t bytes = entry.chunk->memory_usage();
+            resident_bytes_ = resident_bytes_ - entry.bytes + bytes;
+            entry.bytes = bytes;
+            if (entry.chunk->take_referenced() || is_protected(entry.chunk->get_position())) {
+                ++hand_;
+                continue;
+            }
+            victims.push_back(entry.chunk);
+            erase_at(hand_);
+        }
+        return victims;
+    }
+
+    size_t size() const { return ring_.size(); }
+    size_t resident_bytes() const { return resident_bytes_; }
+};
+
+struct ChunkViewer {
+    f64 x = 0;
+    f64 z = 0;
+    f64 heading_x = 0;
+    f64 heading_z = 0;
+};
+
+class ChunkLoadQueue {
+public:
+    static constexpr f64 HEADING_BIAS = 0.3;
+
+private:
+    struct Entry {
+        f64 priority;
+        u64 sequence;
+        ChunkPos pos;
+
+        bool operator<(const Entry& other) const {
+            if (priority != other.priority) return priority > other.priority;
+            return sequence > other.sequence;
+        }
+    };
+
+    mutable std::mutex mutex_;
+    std::vector<Entry> heap_;
+    std::unordered_map<ChunkPos, bool, ChunkPosHash> needs_viewer_;
+    std::unordered_map<u32, ChunkViewer> viewers_;
+    u64 next_sequence_ = 0;
+    bool stale_ = false;
+
+    f64 priority_of(const ChunkPos& pos) const {
+        f64 best = std::numeric_limits<f64>::max();
+        for (const auto& [id, viewer] : viewers_) {
+            f64 dx = (pos.x * CHUNK_SIZE + CHUNK_SIZE / 2 - viewer.x) / CHUNK_SIZE;
+            f64 dz = (pos.z * CHUNK_SIZE + CHUNK_SIZE / 2 - viewer.z) / CHUNK_SIZE;
+            f64 distance = std::sqrt(dx * dx + dz * dz);
+            f64 alignment = distance > 0 ? (dx * viewer.heading_x + dz * viewer.heading_z) / distance : 0;
+            best = std::min(best, distance * (1.0 - HEADING_BIAS * alignment));
+        }
+        return best;
+    }
+
+    template<typename IsNeeded>
+    void reprioritize(IsNeeded& is_needed, std::vector<ChunkPos>& cancelled) {
+        std::vector<Entry> kept;
+        kept.reserve(heap_.size());
+        for (auto& entry : heap_) {
+            if (needs_viewer_[entry.pos] && !is_needed(entry.pos)) {
+                needs_viewer_.erase(entry.pos);
+                cancelled.push_back(entry.pos);
+                continue;
+            }
+            entry.priority = priority_of(entry.pos);
+            kept.push_back(entry);
+        }
+        heap_ = std::move(kept);
+        std::make_heap(heap_.begin(), heap_.end());
+        stale_ = false;
+    }
+
+public:
+    void push(const ChunkPos& pos, bool needs_viewer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!needs_viewer_.try_emplace(pos, needs_viewer).second) return;
+        heap_.push_back({priority_of(pos), next_sequence_++, pos});
+        std::push_heap(heap_.begin(), heap_.end());
+    }
+
+    void keep(const ChunkPos& pos) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = needs_viewer_.find(pos);
+        if (it != needs_viewer_.end()) it->second = false;
+    }
+
+    template<typename IsNeeded>
+    bool pop(ChunkPos& out, IsNeeded&& is_needed, std::vector<ChunkPos>& cancelled) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stale_) reprioritize(is_needed, cancelled);
+        while (!heap_.empty()) {
+            std::pop_heap(heap_.begin(), heap_.end());
+            ChunkPos pos = heap_.back().pos;
+            heap_.pop_back();
+            bool needs_viewer = needs_viewer_[pos];
+            needs_viewer_.erase(pos);
+            if (needs_viewer && !is_needed(pos)) {
+                cancelled.push_back(pos);
+                continue;
+            }
+            out = pos;
+            return true;
+        }
+        return false;
+    }
+
+    void update_viewer(u32 id, const ChunkViewer& viewer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        viewers_[id] = viewer;
+        stale_ = true;
+    }
+
+    void remove_viewer(u32 id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (viewers_.erase(id)) stale_ = true;
+    }
+
+    bool empty() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return heap_.empty();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return heap_.size();
     }
 };
 
 class ChunkManager {
 private:
-    std::unordered_map<ChunkPos, ChunkPtr, ChunkPosHash> loaded_chunks_;
-    std::unordered_set<ChunkPos, ChunkPosHash> pending_chunks_;
-    std::mutex chunk_mutex_;
+    ChunkTable chunks_;
+    std::function<void(const BlockChangeSet&)> change_listener_;
+    std::mutex listener_mutex_;
+
+    ChunkClock clock_;
+    std::mutex eviction_mutex_;
+    std::unordered_map<ChunkPos, u32, ChunkPosHash> view_counts_;
+    mutable std::mutex view_mutex_;
+    ChunkStorage* storage_ = nullptr;
+    std::atomic<BlockChangeJournal*> journal_{nullptr};
+
+    // Evicted dirty chunks stay reachable here until their background save lands, so reloading
+    // one never reads the older copy on disk or generates over it.
+    std::unordered_map<ChunkPos, ChunkPtr, ChunkPosHash> write_back_;
+    std::mutex write_back_mutex_;
 
     std::atomic<size_t> max_loaded_chunks_{256};
+    std::atomic<size_t> memory_budget_bytes_{size_t(512) << 20};
+    std::atomic<size_t> resident_bytes_{0};
     std::atomic<bool> auto_unload_enabled_{true};
-    std::atomic<i64> chunk_timeout_ms_{300000};
+    std::atomic<u64> stored_loads_{0};
+    std::atomic<u64> generated_loads_{0};
+    std::atomic<u64> failed_loads_{0};
+
+    ChunkLoadQueue load_queue_;
+    std::atomic<size_t> active_loaders_{0};
+    std::atomic<size_t> max_concurrent_loads_{0};
+    std::atomic<u64> cancelled_loads_{0};
+
+    // Loader and background save tasks capture this; the destructor waits for them to finish.
+    std::atomic<bool> stopping_{false};
+    size_t running_tasks_ = 0;
+    std::mutex task_mutex_;
+    std::condition_variable task_cv_;
+
+    void notify_changes(const BlockChangeSet& changes) {
+        if (changes.empty()) return;
+        std::function<void(const BlockChangeSet&)> listener;
+        {
+            std::lock_guard<std::mutex> lock(listener_mutex_);
+            listener = change_listener_;
+        }
+        if (listener) listener(changes);
+    }
 
-    void cleanup_old_chunks() {
-        if (!auto_unload_enabled_.load()) return;
-        auto now = std::chrono::steady_clock::now();
-        std::vector<ChunkPos> to_unload;
+    void install_chunk(const ChunkPos& pos, const ChunkPtr& chunk) {
+        auto waiters = chunks_.publish(pos, chunk);
         {
-            std::lock_guard<std::mutex> lock(chunk_mutex_);
-            if (loaded_chunks_.size() <= max_loaded_chunks_.load()) return;
-            for (const auto& [pos, chunk] : loaded_chunks_) {
-                auto age = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    now - chunk->get_last_access()).count();
-                if (age > chunk_timeout_ms_.load()) {
-                    to_unload.push_back(pos);
+            std::lock_guard<std::mutex> lock(eviction_mutex_);
+            clock_.insert(chunk);
+            resident_bytes_.store(clock_.resident_bytes(), std::memory_order_relaxed);
+        }
+        notify_waiters(waiters, chunk);
+        enforce_memory_budget();
+    }
+
+    static void notify_waiters(std::vector<ChunkCallback>& waiters, const ChunkPtr& chunk) {
+        for (auto& waiter : waiters) {
+            try {
+                waiter(chunk);
+            } catch (...) {
+            }
+        }
+    }
+
+    ChunkPtr take_write_back(const ChunkPos& pos) {
+        std::lock_guard<std::mutex> lock(write_back_mutex_);
+        auto it = write_back_.find(pos);
+        if (it == write_back_.end()) return nullptr;
+        ChunkPtr chunk = std::move(it->second);
+        write_back_.erase(it);
+        return chunk;
+    }
+
+    // Only a chunk storage reports as never stored is generated; read failures propagate.
+    ChunkPtr read_or_generate(const ChunkPos& pos) {
+        if (auto chunk = take_write_back(pos)) {
+            stored_loads_.fetch_add(1, std::memory_order_relaxed);
+            return chunk;
+        }
+        if (storage_) {
+            if (auto chunk = storage_->read_chunk(pos)) {
+                stored_loads_.fetch_add(1, std::memory_order_relaxed);
+                return chunk;
+            }
+        }
+        auto chunk = std::make_shared<Chunk>(pos);
+        chunk->generate_flat_world();
+        generated_loads_.fetch_add(1, std::memory_order_relaxed);
+        return chunk;
+    }
+
+    void load_now(const ChunkPos& pos) {
+        ChunkPtr chunk;
+        try {
+            chunk = read_or_generate(pos);
+        } catch (...) {
+            failed_loads_.fetch_add(1, std::memory_order_relaxed);
+            auto waiters = chunks_.cancel(pos);
+            notify_waiters(waiters, nullptr);
+            return;
+        }
+        install_chunk(pos, chunk);
+    }
+
+    void cancel_loads(const std::vector<ChunkPos>& positions) {
+        for (const auto& pos : positions) {
+            auto waiters = chunks_.cancel(pos);
+            notify_waiters(waiters, nullptr);
+        }
+        cancelled_loads_.fetch_add(positions.size(), std::memory_order_relaxed);
+    }
+
+    size_t loader_limit() const {
+        size_t limit = max_concurrent_loads_.load(std::memory_order_relaxed);
+        return limit ? limit : std::max<size_t>(1, g_thread_pool.size() / 2);
+    }
+
+    bool begin_task(bool load) {
+        std::lock_guard<std::mutex> lock(task_mutex_);
+        if (load && stopping_.load(std::memory_order_relaxed)) return false;
+        running_tasks_++;
+        return true;
+    }
+
+    // Must be the last thing a task does with this manager.
+    void end_task() {
+        std::lock_guard<std::mutex> lock(task_mutex_);
+        if (--running_tasks_ == 0) task_cv_.notify_all();
+    }
+
+    void run_loader() {
+        std::vector<ChunkPos> cancelled;
+        ChunkPos pos;
+        while (!stopping_.load(std::memory_order_acquire) &&
+               load_queue_.pop(pos, [this](const ChunkPos& p) { return is_viewed(p); }, cancelled)) {
+            cancel_loads(cancelled);
+            cancelled.clear();
+            load_now(pos);
+        }
+        cancel_loads(cancelled);
+        active_loaders_.fetch_sub(1, std::memory_order_acq_rel);
+        if (!load_queue_.empty()) start_loaders();
+        end_task();
+    }
+
+    void start_loaders() {
+        size_t active = active_loaders_.load(std::memory_order_acquire);
+        while (active < loader_limit() && !load_queue_.empty()) {
+            if (active_loaders_.compare_exchange_weak(active, active + 1, std::memory_order_acq_rel)) {
+                if (!begin_task(true)) {
+                    active_loaders_.fetch_sub(1, std::memory_order_acq_rel);
+                    return;
+                }
+                try {
+                    g_thread_pool.submit([this]() { run_loader(); });
+                } catch (...) {
+                    active_loaders_.fetch_sub(1, std::memory_order_acq_rel);
+                    end_task();
+                    throw;
                 }
+                active = active_loaders_.load(std::memory_order_acquire);
             }
         }
-        for (const auto& pos : to_unload) {
-            unload_chunk(pos);
+    }
+
+    void schedule_load(const ChunkPos& pos) {
+        load_queue_.push(pos, is_viewed(pos));
+        start_loaders();
+    }
+
+    static void journal_paste(BlockChangeJournal& journal, const BlockVolume& volume, const Position& origin, i32 cx, i32 cz) {
+        i32 x0 = std::max(origin.x, cx * CHUNK_SIZE), x1 = std::min(origin.x + volume.size_x, (cx + 1) * CHUNK_SIZE);
+        i32 z0 = std::max(origin.z, cz * CHUNK_SIZE), z1 = std::min(origin.z + volume.size_z, (cz + 1) * CHUNK_SIZE);
+        i32 y0 = std::max(origin.y, WORLD_MIN_Y), y1 = std::min(origin.y + volume.size_y, WORLD_MAX_Y);
+        for (i32 y = y0; y < y1; ++y)
+            for (i32 z = z0; z < z1; ++z)
+                for (i32 x = x0; x < x1; ++x)
+                    journal.record_set(Position(x, y, z), volume.blocks[volume.index_of(x - origin.x, y - origin.y, z - origin.z)]);
+    }
+
+    // Removing the chunk and parking it in write_back_ happen under one lock, so a load that
+    // misses the table is guaranteed to find it there.
+    ChunkPtr evict(const ChunkPos& pos, const Chunk* expected = nullptr) {
+        std::lock_guard<std::mutex> lock(write_back_mutex_);
+        ChunkPtr chunk = chunks_.remove(pos, expected);
+        if (chunk && chunk->is_dirty() && storage_) write_back_[pos] = chunk;
+        return chunk;
+    }
+
+    void persist(const ChunkPtr& chunk) {
+        if (!chunk || !chunk->is_dirty() || !storage_) return;
+        begin_task(false);
+        try {
+            storage_->save_chunk_in_background(chunk, [this, chunk]() {
+                retire_write_back(chunk);
+                end_task();
+            });
+        } catch (...) {
+            end_task();
+            throw;
         }
     }
 
+    // A chunk that is still dirty either failed to save or was reloaded and edited again; it
+    // stays parked for the next eviction or checkpoint to save.
+    void retire_write_back(const ChunkPtr& chunk) {
+        if (chunk->is_dirty()) return;
+        std::lock_guard<std::mutex> lock(write_back_mutex_);
+        auto it = write_back_.find(chunk->get_position());
+        if (it != write_back_.end() && it->second == chunk) write_back_.erase(it);
+    }
+
 public:
     ChunkManager() = default;
 
+    // Queued loads are abandoned, but loads already running and saves of evicted chunks are
+    // allowed to finish.
+    ~ChunkManager() {
+        stopping_.store(true, std::memory_order_release);
+        std::unique_lock<std::mutex> lock(task_mutex_);
+        task_cv_.wait(lock, [this]() { return running_tasks_ == 0; });
+    }
+
+    ChunkManager(const ChunkManager&) = delete;
+    ChunkManager& operator=(const ChunkManager&) = delete;
+
     ChunkPtr get_chunk(const ChunkPos& pos) {
-        std::lock_guard<std::mutex> lock(chunk_mutex_);
-        auto it = loaded_chunks_.find(pos);
-        if (it != loaded_chunks_.end()) {
-            it->second->touch();
-            return it->second;
+        auto chunk = chunks_.find(pos);
+        if (chunk) chunk->touch();
+        return chunk;
+    }
+
+    ChunkPtr request_chunk(const ChunkPos& pos, ChunkCallback on_ready = nullptr) {
+        bool reserved;
+        auto existing = chunks_.reserve(pos, reserved, on_ready);
+        if (existing) {
+            existing->touch();
+            if (on_ready) on_ready(existing);
+            return existing;
+        }
+        if (reserved) {
+            schedule_load(pos);
+        } else if (!is_viewed(pos)) {
+            load_queue_.keep(pos);
         }
         return nullptr;
     }
 
     ChunkPtr load_chunk(const ChunkPos& pos) {
-        {
-            std::lock_guard<std::mutex> lock(chunk_mutex_);
-            auto it = loaded_chunks_.find(pos);
-            if (it != loaded_chunks_.end()) {
-                it->second->touch();
-                return it->second;
-            }
-            if (pending_chunks_.find(pos) != pending_chunks_.end()) {
-                return nullptr;
-            }
-            pending_chunks_.insert(pos);
-        }
-
-        g_thread_pool.submit([this, pos]() {
-            auto chunk = std::make_shared<Chunk>(pos);
-            chunk->generate_flat_world();
-            {
-                std::lock_guard<std::mutex> lock(chunk_mutex_);
-                loaded_chunks_[pos] = chunk;
-                pending_chunks_.erase(pos);
-            }
-            cleanup_old_chunks();
-        });
+        return request_chunk(pos);
+    }
 
-        return nullptr;
+    std::shared_future<ChunkPtr> load_chunk_async(const ChunkPos& pos) {
+        auto promise = std::make_shared<std::promise<ChunkPtr>>();
+        std::shared_future<ChunkPtr> future = promise->get_future().share();
+        request_chunk(pos, [promise](const ChunkPtr& chunk) { promise->set_value(chunk); });
+        return future;
     }
 
     void unload_chunk(const ChunkPos& pos) {
-        ChunkPtr chunk_to_save;
         {
-            std::lock_guard<std::mutex> lock(chunk_mutex_);
-            auto it = loaded_chunks_.find(pos);
-            if (it != loaded_chunks_.end()) {
-                chunk_to_save = it->second;
-                loaded_chunks_.erase(it);
+            std::lock_guard<std::mutex> lock(eviction_mutex_);
+            clock_.erase(pos);
+            resident_bytes_.store(clock_.resident_bytes(), std::memory_order_relaxed);
+        }
+        persist(evict(pos));
+    }
+
+    size_t enforce_memory_budget() {
+        if (!auto_unload_enabled_.load()) return 0;
+        std::unique_lock<std::mutex> lock(eviction_mutex_, std::try_to_lock);
+        if (!lock.owns_lock()) return 0;
+
+        std::vector<ChunkPtr> victims;
+        {
+            std::lock_guard<std::mutex> view_lock(view_mutex_);
+            victims = clock_.select_victims(memory_budget_bytes_.load(), max_loaded_chunks_.load(),
+                [this](const ChunkPos& pos) { return view_counts_.count(pos) != 0; });
+        }
+        resident_bytes_.store(clock_.resident_bytes(), std::memory_order_relaxed);
+        lock.unlock();
+
+        for (const auto& victim : victims) {
+            if (evict(victim->get_position(), victim.get())) {
+                persist(victim);
             }
         }
-        if (chunk_to_save && chunk_to_save->is_dirty()) {
-            g_thread_pool.submit([chunk_to_save]() {
-            });
+        return victims.size();
+    }
+
+    void retain_view(const ChunkPos& pos) {
+        std::lock_guard<std::mutex> lock(view_mutex_);
+        view_counts_[pos]++;
+    }
+
+    void release_view(const ChunkPos& pos) {
+        std::lock_guard<std::mutex> lock(view_mutex_);
+        auto it = view_counts_.find(pos);
+        if (it != view_counts_.end() && --it->second == 0) {
+            view_counts_.erase(it);
         }
     }
 
-    Block get_block(const Position& pos) {
-        ChunkPos chunk_pos(pos.x >> 4, pos.z >> 4);
-        auto chunk = get_chunk(chunk_pos);
+    bool is_viewed(const ChunkPos& pos) const {
+        std::lock_guard<std::mutex> lock(view_mutex_);
+        return view_counts_.count(pos) != 0;
+    }
+
+    void update_viewer(u32 id, const ChunkViewer& viewer) {
+        load_queue_.update_viewer(id, viewer);
+    }
+
+    void remove_viewer(u32 id) {
+        load_queue_.remove_viewer(id);
+    }
+
+    void set_storage(ChunkStorage* storage) {
+        storage_ = storage;
+    }
+
+    void set_journal(BlockChangeJournal* journal) {
+        journal_.store(journal, std::memory_order_release);
+    }
+
+    Block get_block(const Position& pos) const {
+        EpochGuard guard;
+        Chunk* chunk = chunks_.find_raw(ChunkPos(pos.x >> 4, pos.z >> 4));
         if (!chunk) return Block();
+        chunk->mark_referenced();
         i32 local_x = pos.x & 15;
         i32 local_z = pos.z & 15;
         return chunk->get_block(local_x, pos.y, local_z);
@@ -269,23 +1272,112 @@ public:
         i32 local_x = pos.x & 15;
         i32 local_z = pos.z & 15;
         chunk->set_block(local_x, pos.y, local_z, block);
+        if (auto* journal = journal_.load(std::memory_order_acquire)) {
+            journal->record_set(pos, block.id);
+        }
+    }
+
+    BlockChangeSet fill(const Position& from, const Position& to, const Block& block) {
+        BlockChangeSet changes;
+        i32 min_x = std::min(from.x, to.x), max_x = std::max(from.x, to.x);
+        i32 min_y = std::min(from.y, to.y), max_y = std::max(from.y, to.y);
+        i32 min_z = std::min(from.z, to.z), max_z = std::max(from.z, to.z);
+        auto* journal = journal_.load(std::memory_order_acquire);
+        for (i32 cx = min_x >> 4; cx <= max_x >> 4; ++cx) {
+            for (i32 cz = min_z >> 4; cz <= max_z >> 4; ++cz) {
+                auto chunk = get_chunk(ChunkPos(cx, cz));
+                if (!chunk) continue;
+                chunk->fill(min_x - cx * CHUNK_SIZE, min_y, min_z - cz * CHUNK_SIZE,
+                            max_x - cx * CHUNK_SIZE, max_y, max_z - cz * CHUNK_SIZE, block, &changes);
+                if (journal) {
+                    i32 base_x = cx * CHUNK_SIZE, base_z = cz * CHUNK_SIZE;
+                    journal->record_fill(Position(std::max(min_x, base_x), min_y, std::max(min_z, base_z)),
+                                         Position(std::min(max_x, base_x + CHUNK_SIZE - 1), max_y,
+                                                  std::min(max_z, base_z + CHUNK_SIZE - 1)), block.id);
+                }
+            }
+        }
+        notify_changes(changes);
+        return changes;
+    }
+
+    BlockChangeSet set_blocks(const std::vector<BlockChange>& edits) {
+        std::unordered_map<ChunkPos, std::vector<BlockChange>, ChunkPosHash> by_chunk;
+        for (const auto& edit : edits) {
+            by_chunk[ChunkPos(edit.position.x >> 4, edit.position.z >> 4)].push_back(edit);
+        }
+        BlockChangeSet changes;
+        auto* journal = journal_.load(std::memory_order_acquire);
+        for (const auto& [pos, chunk_edits] : by_chunk) {
+            auto chunk = get_chunk(pos);
+            if (!chunk) continue;
+            chunk->set_blocks(chunk_edits, &changes);
+            if (!journal) continue;
+            for (const auto& edit : chunk_edits) {
+                journal->record_set(edit.position, edit.block.id);
+            }
+        }
+        notify_changes(changes);
+        return changes;
+    }
+
+    BlockChangeSet paste(const BlockVolume& volume, const Position& origin) {
+        BlockChangeSet changes;
+        if (volume.size_x <= 0 || volume.size_y <= 0 || volume.size_z <= 0) return changes;
+        for (i32 cx = origin.x >> 4; cx <= (origin.x + volume.size_x - 1) >> 4; ++cx) {
+            for (i32 cz = origin.z >> 4; cz <= (origin.z + volume.size_z - 1) >> 4; ++cz) {
+                auto chunk = get_chunk(ChunkPos(cx, cz));
+                if (!chunk) continue;
+                chunk->copy_blocks(volume, origin, &changes);
+                if (auto* journal = journal_.load(std::memory_order_acquire)) {
+                    journal_paste(*journal, volume, origin, cx, cz);
+                }
+            }
+        }
+        notify_changes(changes);
+        return changes;
+    }
+
+    void set_change_listener(std::function<void(const BlockChangeSet&)> listener) {
+        std::lock_guard<std::mutex> lock(listener_mutex_);
+        change_listener_ = std::move(listener);
     }
 
     std::vector<ChunkPtr> get_chunks_in_range(const ChunkPos& center, i32 radius) {
         std::vector<ChunkPtr> result;
-        std::lock_guard<std::mutex> lock(chunk_mutex_);
+        EpochGuard guard;
         for (i32 dx = -radius; dx <= radius; ++dx) {
             for (i32 dz = -radius; dz <= radius; ++dz) {
-                ChunkPos pos(center.x + dx, center.z + dz);
-                auto it = loaded_chunks_.find(pos);
-                if (it != loaded_chunks_.end()) {
-                    result.push_back(it->second);
+                Chunk* chunk = chunks_.find_raw(ChunkPos(center.x + dx, center.z + dz));
+                if (chunk) {
+                    result.push_back(chunk->shared_from_this());
                 }
             }
         }
         return result;
     }
 
+    // Includes evicted chunks whose background save has not landed, and forgets parked chunks
+    // that have since been saved.
+    std::vector<ChunkSnapshot> snapshot_dirty_chunks() {
+        std::vector<ChunkSnapshot> snapshots;
+        chunks_.for_each([&snapshots](const ChunkPos&, const ChunkPtr& chunk) {
+            if (chunk && chunk->is_dirty()) {
+                snapshots.emplace_back(chunk);
+            }
+        });
+        std::lock_guard<std::mutex> lock(write_back_mutex_);
+        for (auto it = write_back_.begin(); it != write_back_.end();) {
+            if (it->second->is_dirty()) {
+                snapshots.emplace_back(it->second);
+                ++it;
+            } else {
+                it = write_back_.erase(it);
+            }
+        }
+        return snapshots;
+    }
+
     void load_chunks_around(const ChunkPos& center, i32 radius) {
         for (i32 dx = -radius; dx <= radius; ++dx) {
             for (i32 dz = -radius; dz <= radius; ++dz) {
@@ -298,13 +1390,40 @@ public:
     }
 
     size_t get_loaded_chunk_count() const {
-        std::lock_guard<std::mutex> lock(chunk_mutex_);
-        return loaded_chunks_.size();
+        return chunks_.size();
     }
 
     size_t get_pending_chunk_count() const {
-        std::lock_guard<std::mutex> lock(chunk_mutex_);
-        return pending_chunks_.size();
+        return chunks_.pending_count();
+    }
+
+    size_t get_write_back_count() {
+        std::lock_guard<std::mutex> lock(write_back_mutex_);
+        return write_back_.size();
+    }
+
+    u64 get_stored_load_count() const {
+        return stored_loads_.load(std::memory_order_relaxed);
+    }
+
+    u64 get_generated_load_count() const {
+        return generated_loads_.load(std::memory_order_relaxed);
+    }
+
+    u64 get_failed_load_count() const {
+        return failed_loads_.load(std::memory_order_relaxed);
+    }
+
+    u64 get_cancelled_load_count() const {
+        return cancelled_loads_.load(std::memory_order_relaxed);
+    }
+
+    size_t get_queued_load_count() const {
+        return load_queue_.size();
+    }
+
+    void set_max_concurrent_loads(size_t loads) {
+        max_concurrent_loads_.store(loads);
     }
 
     void set_max_loaded_chunks(size_t max_chunks) {
@@ -315,8 +1434,16 @@ public:
         auto_unload_enabled_.store(enabled);
     }
 
-    void set_chunk_timeout(i64 timeout_ms) {
-        chunk_timeout_ms_.store(timeout_ms);
+    void set_memory_budget(size_t bytes) {
+        memory_budget_bytes_.store(bytes);
+    }
+
+    size_t get_memory_budget() const {
+        return memory_budget_bytes_.load();
+    }
+
+    size_t get_resident_bytes() const {
+        return resident_bytes_.load(std::memory_order_relaxed);
     }
 };
 
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "core/types.hpp"
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace mc::world {
+
+class MappedRegion {
+private:
+    u8* data_ = nullptr;
+    size_t capacity_ = 0;
+
+    MappedRegion(u8* data, size_t capacity) : data_(data), capacity_(capacity) {}
+
+public:
+    ~MappedRegion() {
+#ifndef _WIN32
+        if (data_) munmap(data_, capacity_);
+#endif
+    }
+
+    MappedRegion(const MappedRegion&) = delete;
+    MappedRegion& operator=(const MappedRegion&) = delete;
+
+    static std::unique_ptr<MappedRegion> map(const std::string& path, size_t capacity) {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return nullptr;
+        void* data = mmap(nullptr, capacity, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) return nullptr;
+        madvise(data, capacity, MADV_RANDOM);
+        return std::unique_ptr<MappedRegion>(new MappedRegion(static_cast<u8*>(data), capacity));
+#else
+        return nullptr;
+#endif
+    }
+
+    const u8* data() const { return data_; }
+    size_t capacity() const { return capacity_; }
+
+    void prefetch(size_t offset, size_t length) const {
+#ifndef _WIN32
+        static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        if (offset >= capacity_) return;
+        size_t aligned = offset & ~(page_size - 1);
+        length = std::min(length + (offset - aligned), capacity_ - aligned);
+        madvise(data_ + aligned, length, MADV_WILLNEED);
+#endif
+    }
+};
+
+}
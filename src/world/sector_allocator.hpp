@@ -0,0 +1,159 @@
+#pragma once
+
+#include "core/types.hpp"
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace mc::world {
+
+class SectorAllocator {
+public:
+    static constexpr u32 SECTOR_SIZE = 4096;
+    static constexpr u32 HEADER_SECTORS = 2;
+    static constexpr u32 MAX_CHUNK_SECTORS = 255;
+    static constexpr u32 NONE = 0;
+
+private:
+    std::vector<u64> used_;
+    u32 end_ = HEADER_SECTORS;
+    u32 used_count_ = 0;
+
+    bool test(u32 sector) const {
+        return sector / 64 < used_.size() && (used_[sector / 64] >> (sector % 64)) & 1;
+    }
+
+    void set(u32 offset, u32 count, bool used) {
+        if (offset + count > used_.size() * 64) {
+            used_.resize((offset + count + 63) / 64, 0);
+        }
+        for (u32 sector = offset; sector < offset + count; ++sector) {
+            u64 bit = u64(1) << (sector % 64);
+            bool was_used = used_[sector / 64] & bit;
+            if (was_used == used) continue;
+            used_[sector / 64] ^= bit;
+            used_count_ += used ? 1 : -1;
+        }
+    }
+
+    u32 find_free_run(u32 count, u32 limit) const {
+        u32 best_offset = NONE;
+        u32 best_length = 0;
+        u32 sector = HEADER_SECTORS;
+        while (sector < limit) {
+            if (test(sector)) {
+                ++sector;
+                continue;
+            }
+            u32 start = sector;
+            while (sector < limit && !test(sector)) ++sector;
+            u32 length = sector - start;
+            if (length < count) continue;
+            if (best_offset == NONE || length < best_length) {
+                best_offset = start;
+                best_length = length;
+                if (length == count) break;
+            }
+        }
+        return best_offset;
+    }
+
+public:
+    static u32 offset_of(u32 location) { return location >> 8; }
+    static u32 count_of(u32 location) { return location & 0xFF; }
+    static u32 make_location(u32 offset, u32 count) { return (offset << 8) | (count & 0xFF); }
+    static u32 sectors_for(size_t bytes) { return static_cast<u32>((bytes + SECTOR_SIZE - 1) / SECTOR_SIZE); }
+
+    template<typename Locations>
+    void rebuild(const Locations& locations, u32 file_sectors) {
+        used_.clear();
+        used_count_ = 0;
+        set(0, HEADER_SECTORS, true);
+        end_ = std::max(file_sectors, HEADER_SECTORS);
+        for (const auto& entry : locations) {
+            u32 location = entry;
+            u32 offset = offset_of(location);
+            u32 count = count_of(location);
+            if (offset < HEADER_SECTORS || count == 0) continue;
+            set(offset, count, true);
+            end_ = std::max(end_, offset + count);
+        }
+    }
+
+    u32 allocate(u32 count) {
+        if (count == 0 || count > MAX_CHUNK_SECTORS) return NONE;
+        u32 offset = find_free_run(count, end_);
+        if (offset == NONE) {
+            offset = end_;
+            while (offset > HEADER_SECTORS && !test(offset - 1)) --offset;
+            end_ = offset + count;
+        }
+        set(offset, count, true);
+        return offset;
+    }
+
+    // Moves a rewritten chunk into a free run whenever one exists, so its old sectors stay intact
+    // until the new copy is committed. Rewriting in place is only a fallback when the file has no
+    // room elsewhere.
+    u32 reallocate(u32 location, u32 count) {
+        u32 offset = offset_of(location);
+        u32 old_count = count_of(location);
+        if (offset < HEADER_SECTORS || old_count == 0) return allocate(count);
+        if (count == 0 || count > MAX_CHUNK_SECTORS) return NONE;
+        u32 relocated = find_free_run(count, end_);
+        if (relocated != NONE) {
+            set(relocated, count, true);
+            return relocated;
+        }
+        if (count <= old_count) {
+            set(offset + count, old_count - count, false);
+            return offset;
+        }
+        bool fits = true;
+        for (u32 sector = offset + old_count; sector < offset + count; ++sector) {
+            if (test(sector)) {
+                fits = false;
+                break;
+            }
+        }
+        if (fits) {
+            set(offset + old_count, count - old_count, true);
+            end_ = std::max(end_, offset + count);
+            return offset;
+        }
+        return allocate(count);
+    }
+
+    void release(u32 location) {
+        u32 offset = offset_of(location);
+        if (offset >= HEADER_SECTORS) set(offset, count_of(location), false);
+    }
+
+    u32 claim(u32 offset, u32 count) {
+        set(offset, count, true);
+        end_ = std::max(end_, offset + count);
+        return offset;
+    }
+
+    u32 shrink_to_fit() {
+        while (end_ > HEADER_SECTORS && !test(end_ - 1)) --end_;
+        return end_;
+    }
+
+    u32 file_sectors() const { return end_; }
+    u32 used_sectors() const { return used_count_; }
+    u32 free_sectors() const { return end_ - std::min(end_, used_count_); }
+
+    u32 free_runs() const {
+        u32 runs = 0;
+        bool in_run = false;
+        for (u32 sector = HEADER_SECTORS; sector < end_; ++sector) {
+            bool free = !test(sector);
+            if (free && !in_run) ++runs;
+            in_run = free;
+        }
+        return runs;
+    }
+};
+
+}
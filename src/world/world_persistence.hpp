@@ -1,34 +1,171 @@
 #pragma once
 
 #include "chunk.hpp"
+#include "mapped_region.hpp"
+#include "sector_allocator.hpp"
+#include "core/async_io.hpp"
 #include "core/buffer.hpp"
+#include "core/compression.hpp"
+#include "core/crc32c.hpp"
+#include "core/logger.hpp"
 #include "core/thread_pool.hpp"
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <future>
+#include <shared_mutex>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace mc::world {
 
-class WorldPersistence {
+class ChunkChecksumError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+struct SnapshotSaveReport {
+    size_t chunks = 0;
+    size_t saved = 0;
+    size_t failed = 0;
+    u64 bytes = 0;
+    f64 duration_ms = 0.0;
+};
+
+using SnapshotSaveCallback = std::function<void(const SnapshotSaveReport&)>;
+
+struct RegionCacheStats {
+    u64 hits = 0;
+    u64 misses = 0;
+    u64 evictions = 0;
+    size_t open_handles = 0;
+    size_t cached_headers = 0;
+};
+
+struct RegionScanReport {
+    i32 region_x = 0;
+    i32 region_z = 0;
+    size_t chunks = 0;
+    size_t corrupt_chunks = 0;
+    size_t dropped_chunks = 0;
+    u64 file_bytes = 0;
+    u64 used_bytes = 0;
+    u64 payload_bytes = 0;
+    u64 free_bytes = 0;
+    u32 free_runs = 0;
+    u64 moved_bytes = 0;
+    u64 compacted_file_bytes = 0;
+    std::vector<std::string> errors;
+};
+
+struct RegionStorageStats {
+    size_t region_files = 0;
+    u64 file_bytes = 0;
+    u64 used_bytes = 0;
+    u64 free_bytes = 0;
+    u32 free_runs = 0;
+    u64 bytes_grown = 0;
+    u64 raw_chunk_bytes = 0;
+    u64 stored_chunk_bytes = 0;
+    u64 in_place_writes = 0;
+    u64 relocated_writes = 0;
+    u64 compacted_bytes = 0;
+    u64 mapped_reads = 0;
+    u64 locked_reads = 0;
+    u64 header_writes = 0;
+    u64 synced_commits = 0;
+    u64 uring_writes = 0;
+    u64 uring_submits = 0;
+    u64 unmodified_chunks = 0;
+    u64 delta_chunks = 0;
+    u64 checksum_failures = 0;
+
+    f64 fragmentation() const {
+        u64 payload = used_bytes + free_bytes;
+        return payload ? static_cast<f64>(free_bytes) / static_cast<f64>(payload) : 0.0;
+    }
+};
+
+class WorldPersistence : public ChunkStorage {
 private:
     std::string world_directory_;
     std::string region_directory_;
-    std::mutex save_mutex_;
+    
+    static constexpr size_t MAX_REGION_BYTES =
+        (size_t(SectorAllocator::HEADER_SECTORS) + size_t(1024) * SectorAllocator::MAX_CHUNK_SECTORS) * SectorAllocator::SECTOR_SIZE;
     
     struct RegionFile {
+        std::mutex mutex;
         std::fstream file;
-        std::array<u32, 1024> locations;
+        int fd = -1;
+        std::string path;
+        std::array<std::atomic<u32>, 1024> locations;
         std::array<u32, 1024> timestamps;
+        SectorAllocator sectors;
+        std::vector<u32> pending_release;
         bool dirty;
+        bool header_loaded = false;
+        bool unsynced = false;
+        
+        std::atomic<MappedRegion*> mapping{nullptr};
+        std::atomic<u64> mapped_bytes{0};
+        std::atomic<u64> write_sequence{0};
+        std::atomic<bool> handle_open{false};
+        std::atomic<u64> last_used{0};
         
         RegionFile() : dirty(false) {
-            locations.fill(0);
+            for (auto& location : locations) location.store(0, std::memory_order_relaxed);
             timestamps.fill(0);
         }
+        
+        ~RegionFile() {
+            close();
+            delete mapping.load();
+        }
+        
+        void close() {
+            file.close();
+#ifndef _WIN32
+            if (fd >= 0) ::close(fd);
+#endif
+            fd = -1;
+        }
+    };
+    
+    struct EncodedChunk {
+        const ChunkSnapshot* snapshot;
+        std::vector<u8> blob;
+        bool written = false;
+    };
+    
+    struct PlannedWrite {
+        i32 chunk_index;
+        u32 old_location;
+        u32 location;
     };
     
-    std::unordered_map<std::pair<i32, i32>, std::unique_ptr<RegionFile>, 
-                       PairHash<i32, i32>> region_files_;
+    class RegionWrite {
+    private:
+        RegionFile& region_;
+        
+    public:
+        explicit RegionWrite(RegionFile& region) : region_(region) {
+            region_.write_sequence.fetch_add(1, std::memory_order_seq_cst);
+        }
+        
+        ~RegionWrite() {
+            region_.mapped_bytes.store(u64(region_.sectors.file_sectors()) * SectorAllocator::SECTOR_SIZE,
+                                       std::memory_order_release);
+            region_.write_sequence.fetch_add(1, std::memory_order_seq_cst);
+        }
+        
+        RegionWrite(const RegionWrite&) = delete;
+        RegionWrite& operator=(const RegionWrite&) = delete;
+    };
     
     template<typename T1, typename T2>
     struct PairHash {
@@ -39,6 +176,57 @@ private:
         }
     };
     
+    using RegionFilePtr = std::shared_ptr<RegionFile>;
+    
+    std::unordered_map<std::pair<i32, i32>, RegionFilePtr, PairHash<i32, i32>> region_files_;
+    mutable std::shared_mutex regions_mutex_;
+    
+    std::atomic<u64> bytes_grown_{0};
+    std::atomic<u64> raw_chunk_bytes_{0};
+    std::atomic<u64> stored_chunk_bytes_{0};
+    std::atomic<u64> in_place_writes_{0};
+    std::atomic<u64> relocated_writes_{0};
+    std::atomic<u64> compacted_bytes_{0};
+    std::atomic<u64> mapped_reads_{0};
+    std::atomic<u64> locked_reads_{0};
+    std::atomic<u64> header_writes_{0};
+    std::atomic<u64> synced_commits_{0};
+    std::atomic<u64> uring_writes_{0};
+    std::atomic<u64> uring_submits_{0};
+    std::atomic<u64> unmodified_chunks_{0};
+    std::atomic<u64> delta_chunks_{0};
+    std::atomic<u64> checksum_failures_{0};
+    
+    std::atomic<size_t> max_open_regions_{256};
+    std::atomic<size_t> open_handles_{0};
+    std::atomic<u64> access_clock_{0};
+    std::atomic<u64> region_cache_hits_{0};
+    std::atomic<u64> region_cache_misses_{0};
+    std::atomic<u64> region_evictions_{0};
+    std::mutex eviction_mutex_;
+    std::atomic<u64> pending_background_saves_{0};
+    // Chunks whose eviction save failed, with the version that needs to land; cleared once a later
+    // save of the same chunk reaches that version.
+    std::unordered_map<ChunkPos, u64, ChunkPosHash> failed_saves_;
+    mutable std::mutex failed_saves_mutex_;
+    std::unordered_map<ChunkPos, u32, ChunkPosHash> quarantined_;
+    std::mutex quarantine_mutex_;
+    
+    std::atomic<int> compression_level_{Z_DEFAULT_COMPRESSION};
+    std::atomic<bool> fast_background_saves_{true};
+    std::atomic<bool> sync_writes_{false};
+    std::atomic<bool> use_io_uring_{true};
+    std::atomic<bool> generator_deltas_{true};
+    
+    static constexpr size_t CHUNK_HEADER_SIZE = 5;
+    // The checksum trails the payload inside the chunk's sectors, where Anvil readers, which stop
+    // at the length field, never look: crc32c of header and payload, then this magic.
+    static constexpr size_t CHECKSUM_TRAILER_SIZE = 8;
+    static constexpr u32 CHECKSUM_MAGIC = 0x43524343;
+    static constexpr u8 EXTERNAL_CHUNK_FLAG = 0x80;
+    static constexpr size_t REGION_HEADER_SIZE = SectorAllocator::HEADER_SECTORS * SectorAllocator::SECTOR_SIZE;
+    static constexpr int FAST_COMPRESSION_LEVEL = Z_BEST_SPEED;
+    
     std::pair<i32, i32> get_region_coords(const ChunkPos& chunk_pos) const {
         return {chunk_pos.x >> 5, chunk_pos.z >> 5};
     }
@@ -51,33 +239,121 @@ private:
         return "r." + std::to_string(region_x) + "." + std::to_string(region_z) + ".mca";
     }
     
-    RegionFile* get_region_file(i32 region_x, i32 region_z) {
+    // Headers stay cached for every region ever touched; only the stream, fd and mapping are
+    // bounded, so reopening an evicted region never rereads its header.
+    RegionFilePtr get_region_file(i32 region_x, i32 region_z) {
         auto key = std::make_pair(region_x, region_z);
-        auto it = region_files_.find(key);
+        RegionFilePtr region_file;
+        {
+            std::shared_lock<std::shared_mutex> lock(regions_mutex_);
+            auto it = region_files_.find(key);
+            if (it != region_files_.end()) {
+                region_file = it->second;
+            }
+        }
         
-        if (it != region_files_.end()) {
-            return it->second.get();
+        if (!region_file) {
+            std::unique_lock<std::shared_mutex> lock(regions_mutex_);
+            auto& slot = region_files_[key];
+            if (!slot) {
+                slot = std::make_shared<RegionFile>();
+                slot->path = region_directory_ + "/" + get_region_filename(region_x, region_z);
+            }
+            region_file = slot;
         }
         
-        auto region_file = std::make_unique<RegionFile>();
-        std::string filename = region_directory_ + "/" + get_region_filename(region_x, region_z);
+        region_file->last_used.store(access_clock_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        if (region_file->handle_open.load(std::memory_order_acquire)) {
+            region_cache_hits_.fetch_add(1, std::memory_order_relaxed);
+            return region_file;
+        }
         
-        region_file->file.open(filename, std::ios::in | std::ios::out | std::ios::binary);
+        {
+            std::lock_guard<std::mutex> lock(region_file->mutex);
+            ensure_open(*region_file);
+        }
+        evict_region_handles();
+        return region_file;
+    }
+    
+    bool ensure_open(RegionFile& region_file) {
+        if (region_file.file.is_open()) return true;
         
-        if (!region_file->file.is_open()) {
-            region_file->file.open(filename, std::ios::out | std::ios::binary);
-            region_file->file.close();
-            region_file->file.open(filename, std::ios::in | std::ios::out | std::ios::binary);
+        region_file.file.open(region_file.path, std::ios::in | std::ios::out | std::ios::binary);
+        if (!region_file.file.is_open()) {
+            region_file.file.open(region_file.path, std::ios::out | std::ios::binary);
+            region_file.file.close();
+            region_file.file.open(region_file.path, std::ios::in | std::ios::out | std::ios::binary);
         }
+        if (!region_file.file.is_open()) return false;
         
-        if (region_file->file.is_open()) {
-            load_region_header(*region_file);
+        region_cache_misses_.fetch_add(1, std::memory_order_relaxed);
+        region_file.last_used.store(access_clock_.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+#ifndef _WIN32
+        region_file.fd = ::open(region_file.path.c_str(), O_RDWR | O_CLOEXEC);
+#endif
+        if (!region_file.header_loaded) {
+            u64 file_size = std::filesystem::file_size(region_file.path);
+            if (file_size < SectorAllocator::HEADER_SECTORS * SectorAllocator::SECTOR_SIZE) {
+                save_region_header(region_file);
+                file_size = SectorAllocator::HEADER_SECTORS * SectorAllocator::SECTOR_SIZE;
+            } else {
+                load_region_header(region_file);
+            }
+            region_file.sectors.rebuild(region_file.locations, SectorAllocator::sectors_for(file_size));
+            region_file.header_loaded = true;
+        }
+        region_file.mapped_bytes.store(u64(region_file.sectors.file_sectors()) * SectorAllocator::SECTOR_SIZE);
+        region_file.mapping.store(MappedRegion::map(region_file.path, MAX_REGION_BYTES).release(), std::memory_order_release);
+        region_file.handle_open.store(true, std::memory_order_release);
+        open_handles_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    
+    void close_region_handle(RegionFile& region_file) {
+        region_file.close();
+        g_epoch_manager.retire(region_file.mapping.exchange(nullptr, std::memory_order_acq_rel));
+        if (region_file.handle_open.exchange(false, std::memory_order_acq_rel)) {
+            open_handles_.fetch_sub(1, std::memory_order_relaxed);
         }
+    }
+    
+    void evict_region_handles() {
+        size_t limit = max_open_regions_.load(std::memory_order_relaxed);
+        if (open_handles_.load(std::memory_order_relaxed) <= limit) return;
+        std::unique_lock<std::mutex> eviction_lock(eviction_mutex_, std::try_to_lock);
+        if (!eviction_lock.owns_lock()) return;
         
-        RegionFile* result = region_file.get();
-        region_files_[key] = std::move(region_file);
+        std::vector<std::pair<u64, RegionFilePtr>> candidates;
+        for (auto& region_file : get_region_files()) {
+            if (region_file->handle_open.load(std::memory_order_acquire)) {
+                candidates.emplace_back(region_file->last_used.load(std::memory_order_relaxed), std::move(region_file));
+            }
+        }
+        if (candidates.size() <= limit) return;
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
         
-        return result;
+        size_t excess = candidates.size() - limit;
+        for (auto& [stamp, region_file] : candidates) {
+            if (excess == 0) break;
+            std::unique_lock<std::mutex> lock(region_file->mutex, std::try_to_lock);
+            if (!lock.owns_lock() || !region_file->file.is_open()) continue;
+            if (region_file->dirty && !try_commit_region_header(*region_file)) continue;
+            close_region_handle(*region_file);
+            region_evictions_.fetch_add(1, std::memory_order_relaxed);
+            excess--;
+        }
+    }
+    
+    std::vector<RegionFilePtr> get_region_files() const {
+        std::shared_lock<std::shared_mutex> lock(regions_mutex_);
+        std::vector<RegionFilePtr> regions;
+        regions.reserve(region_files_.size());
+        for (const auto& [pos, region_file] : region_files_) {
+            regions.push_back(region_file);
+        }
+        return regions;
     }
     
     void load_region_header(RegionFile& region_file) {
@@ -86,41 +362,530 @@ private:
         for (i32 i = 0; i < 1024; ++i) {
             u32 location;
             region_file.file.read(reinterpret_cast<char*>(&location), sizeof(u32));
-            region_file.locations[i] = be32toh(location);
+            region_file.locations[i].store(from_be32(location), std::memory_order_relaxed);
         }
         
         for (i32 i = 0; i < 1024; ++i) {
             u32 timestamp;
             region_file.file.read(reinterpret_cast<char*>(&timestamp), sizeof(u32));
-            region_file.timestamps[i] = be32toh(timestamp);
+            region_file.timestamps[i] = from_be32(timestamp);
         }
+        
+        region_file.file.clear();
     }
     
     void save_region_header(RegionFile& region_file) {
+        std::array<u32, REGION_HEADER_SIZE / sizeof(u32)> header;
+        for (i32 i = 0; i < 1024; ++i) {
+            header[i] = to_be32(region_file.locations[i].load(std::memory_order_relaxed));
+            header[1024 + i] = to_be32(region_file.timestamps[i]);
+        }
+        
         region_file.file.seekp(0);
+        region_file.file.write(reinterpret_cast<const char*>(header.data()), REGION_HEADER_SIZE);
+        region_file.file.flush();
+        region_file.unsynced = true;
+        if (!region_file.file) {
+            region_file.file.clear();
+            throw std::runtime_error("Failed to write region header " + region_file.path);
+        }
+        header_writes_++;
+    }
+    
+    void sync_region_data(RegionFile& region_file, bool force = false) {
+        region_file.file.flush();
+#ifndef _WIN32
+        if (!force && !sync_writes_.load(std::memory_order_relaxed)) return;
+        int fd = region_file.fd >= 0 ? region_file.fd : ::open(region_file.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open " + region_file.path + " for sync");
+        }
+        int result = ::fdatasync(fd);
+        if (fd != region_file.fd) ::close(fd);
+        if (result != 0) {
+            throw std::runtime_error("Failed to sync " + region_file.path);
+        }
+#endif
+        region_file.unsynced = false;
+    }
+    
+    // Hands buffered sector writes to the kernel, where mapped readers can see them.
+    void flush_region_data(RegionFile& region_file) {
+        region_file.file.flush();
+        if (!region_file.file) {
+            region_file.file.clear();
+            throw std::runtime_error("Failed to flush " + region_file.path);
+        }
+    }
+    
+    void commit_region_header(RegionFile& region_file) {
+        sync_region_data(region_file);
+        save_region_header(region_file);
+        sync_region_data(region_file);
+        if (sync_writes_.load(std::memory_order_relaxed)) synced_commits_++;
         
-        for (i32 i = 0; i < 1024; ++i) {
-            u32 location = htobe32(region_file.locations[i]);
-            region_file.file.write(reinterpret_cast<const char*>(&location), sizeof(u32));
+        for (u32 location : region_file.pending_release) {
+            region_file.sectors.release(location);
+        }
+        region_file.pending_release.clear();
+        region_file.dirty = false;
+    }
+    
+    bool try_commit_region_header(RegionFile& region_file) {
+        try {
+            commit_region_header(region_file);
+            return true;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Failed to commit header for " + region_file.path + ": " + e.what());
+            return false;
+        }
+    }
+    
+    size_t commit_region_headers(const std::vector<RegionFilePtr>& regions) {
+        size_t committed = 0;
+        for (const auto& region_file : regions) {
+            std::lock_guard<std::mutex> lock(region_file->mutex);
+            if (region_file->dirty && region_file->file.is_open() && try_commit_region_header(*region_file)) {
+                committed++;
+            }
+        }
+        return committed;
+    }
+    
+    void mark_chunk_saved(const ChunkSnapshot& snapshot) {
+        snapshot.mark_saved();
+        std::lock_guard<std::mutex> lock(failed_saves_mutex_);
+        auto it = failed_saves_.find(snapshot.get_position());
+        if (it != failed_saves_.end() && snapshot.get_version() >= it->second) failed_saves_.erase(it);
+    }
+    
+    // An empty blob means the chunk still matches the generator, so saving it is a no-op; a stored
+    // copy, if any, is left where it is.
+    bool encode_chunk(const ChunkSnapshot& chunk, bool fast, std::vector<u8>& blob) {
+        try {
+            bool deltas = generator_deltas_.load(std::memory_order_relaxed);
+            if (deltas && chunk.get_modified_sections() == 0) {
+                blob.clear();
+                return true;
+            }
+            Buffer chunk_data(65536);
+            serialize_chunk(chunk, chunk_data, deltas);
+            encode_chunk_blob(chunk_data, fast ? FAST_COMPRESSION_LEVEL : compression_level_.load(), blob);
+            return true;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Failed to encode chunk " + std::to_string(chunk.get_position().x) + 
+                     ", " + std::to_string(chunk.get_position().z) + ": " + e.what());
+            return false;
+        }
+    }
+    
+    bool plan_chunk_write(RegionFile& region_file, const ChunkSnapshot& chunk, size_t blob_size, PlannedWrite& plan) {
+        auto [local_x, local_z] = get_local_chunk_coords(chunk.get_position());
+        if (!ensure_open(region_file)) {
+            return false;
+        }
+        if (chunk.chunk()->get_saved_version() >= chunk.get_version()) {
+            return false;
+        }
+        
+        u32 sector_count = SectorAllocator::sectors_for(blob_size);
+        if (sector_count > SectorAllocator::MAX_CHUNK_SECTORS) {
+            LOG_ERROR("Chunk " + std::to_string(chunk.get_position().x) + ", " +
+                     std::to_string(chunk.get_position().z) + " is too large to store (" +
+                     std::to_string(blob_size) + " bytes)");
+            return false;
+        }
+        
+        plan.chunk_index = local_z * 32 + local_x;
+        plan.old_location = region_file.locations[plan.chunk_index].load(std::memory_order_relaxed);
+        
+        u32 old_end = region_file.sectors.file_sectors();
+        u32 sector_offset = region_file.sectors.reallocate(plan.old_location, sector_count);
+        plan.location = SectorAllocator::make_location(sector_offset, sector_count);
+        if (SectorAllocator::count_of(plan.old_location) > 0) {
+            if (sector_offset == SectorAllocator::offset_of(plan.old_location)) {
+                in_place_writes_++;
+            } else {
+                relocated_writes_++;
+                region_file.pending_release.push_back(plan.old_location);
+            }
+        }
+        u32 new_end = region_file.sectors.file_sectors();
+        if (new_end > old_end) {
+            bytes_grown_ += u64(new_end - old_end) * SectorAllocator::SECTOR_SIZE;
+        }
+        return true;
+    }
+    
+    void finish_chunk_write(RegionFile& region_file, const PlannedWrite& plan) {
+        region_file.locations[plan.chunk_index].store(plan.location, std::memory_order_release);
+        region_file.timestamps[plan.chunk_index] = static_cast<u32>(
+            std::chrono::system_clock::now().time_since_epoch().count() / 1000000000);
+        region_file.dirty = true;
+    }
+    
+    void abandon_chunk_write(RegionFile& region_file, const PlannedWrite& plan) {
+        region_file.sectors.release(plan.location);
+        if (SectorAllocator::offset_of(plan.location) == SectorAllocator::offset_of(plan.old_location)) {
+            // Planned in place: hand back the grown tail, or reclaim a shrunk one, so the sectors
+            // match the location the header still holds.
+            region_file.sectors.claim(SectorAllocator::offset_of(plan.old_location),
+                                      SectorAllocator::count_of(plan.old_location));
+            return;
+        }
+        auto it = std::find(region_file.pending_release.rbegin(), region_file.pending_release.rend(), plan.old_location);
+        if (it != region_file.pending_release.rend()) region_file.pending_release.erase(std::next(it).base());
+    }
+    
+    bool write_chunk(RegionFile& region_file, const ChunkSnapshot& chunk, const std::vector<u8>& blob) {
+        PlannedWrite plan;
+        if (!plan_chunk_write(region_file, chunk, blob.size(), plan)) {
+            return false;
+        }
+        try {
+            RegionWrite write(region_file);
+            write_sectors(region_file, SectorAllocator::offset_of(plan.location), blob.data(), blob.size());
+            flush_region_data(region_file);
+            finish_chunk_write(region_file, plan);
+            return true;
+        } catch (const std::exception& e) {
+            abandon_chunk_write(region_file, plan);
+            LOG_ERROR("Failed to save chunk " + std::to_string(chunk.get_position().x) + 
+                     ", " + std::to_string(chunk.get_position().z) + ": " + e.what());
+            return false;
+        }
+    }
+
+    // Waits for the whole batch: the header cannot publish a location before its sectors land.
+    void submit_chunk_writes(IoRing& ring, RegionFile& region_file, const std::vector<PlannedWrite>& plans,
+                             const std::vector<EncodedChunk*>& chunks, std::vector<u8>& written) {
+        region_file.file.flush();
+        std::vector<FileIORequest> requests;
+        std::vector<size_t> indices;
+        for (size_t i = 0; i < plans.size(); ++i) {
+            const auto& blob = chunks[i]->blob;
+            size_t size = size_t(SectorAllocator::count_of(plans[i].location)) * SectorAllocator::SECTOR_SIZE;
+            auto* staging = static_cast<u8*>(g_buffer_pool.allocate(size));
+            std::memcpy(staging, blob.data(), blob.size());
+            std::memset(staging + blob.size(), 0, size - blob.size());
+            FileIORequest& request = requests.emplace_back();
+            request.fd = region_file.fd;
+            request.offset = u64(SectorAllocator::offset_of(plans[i].location)) * SectorAllocator::SECTOR_SIZE;
+            request.data = staging;
+            request.length = static_cast<u32>(size);
+            request.write = true;
+            indices.push_back(i);
+        }
+        if (requests.empty()) return;
+        
+        region_file.unsynced = true;
+        u64 submits = ring.submits();
+        if (!ring.submit(requests.data(), requests.size())) {
+            LOG_ERROR("Batched write to " + region_file.path + " failed for some chunks");
+        }
+        uring_submits_ += ring.submits() - submits;
+        uring_writes_ += requests.size();
+        
+        for (size_t i = 0; i < requests.size(); ++i) {
+            written[indices[i]] = requests[i].done == requests[i].length;
+            g_buffer_pool.deallocate(requests[i].data, requests[i].length);
+        }
+    }
+    
+    // Publishes nothing until every payload has been flushed to the file, so mapped readers never
+    // see a location whose sectors are still sitting in the stream buffer.
+    size_t write_chunks(RegionFile& region_file, std::vector<EncodedChunk>& chunks) {
+        std::vector<PlannedWrite> plans;
+        std::vector<EncodedChunk*> planned;
+        for (auto& chunk : chunks) {
+            PlannedWrite plan;
+            if (plan_chunk_write(region_file, *chunk.snapshot, chunk.blob.size(), plan)) {
+                plans.push_back(plan);
+                planned.push_back(&chunk);
+            }
+        }
+        if (plans.empty()) return 0;
+        
+        RegionWrite write(region_file);
+        std::vector<u8> written(plans.size(), 0);
+        IoRing* ring = use_io_uring_.load(std::memory_order_relaxed) && region_file.fd >= 0 ? thread_io_ring() : nullptr;
+        if (ring) {
+            submit_chunk_writes(*ring, region_file, plans, planned, written);
+        } else {
+            for (size_t i = 0; i < plans.size(); ++i) {
+                try {
+                    write_sectors(region_file, SectorAllocator::offset_of(plans[i].location),
+                                  planned[i]->blob.data(), planned[i]->blob.size());
+                    written[i] = 1;
+                } catch (const std::exception& e) {
+                    LOG_ERROR(std::string("Failed to save chunk: ") + e.what());
+                }
+            }
+            try {
+                flush_region_data(region_file);
+            } catch (const std::exception& e) {
+                LOG_ERROR(e.what());
+                std::fill(written.begin(), written.end(), 0);
+            }
+        }
+        
+        size_t count = 0;
+        for (size_t i = 0; i < plans.size(); ++i) {
+            if (written[i]) {
+                finish_chunk_write(region_file, plans[i]);
+                planned[i]->written = true;
+                count++;
+            } else {
+                abandon_chunk_write(region_file, plans[i]);
+            }
+        }
+        return count;
+    }
+    
+    static void put_be32(u8* out, u32 value) {
+        out[0] = static_cast<u8>(value >> 24);
+        out[1] = static_cast<u8>(value >> 16);
+        out[2] = static_cast<u8>(value >> 8);
+        out[3] = static_cast<u8>(value);
+    }
+    
+    static u32 get_be32(const u8* in) {
+        return (u32(in[0]) << 24) | (u32(in[1]) << 16) | (u32(in[2]) << 8) | u32(in[3]);
+    }
+    
+    void encode_chunk_blob(const Buffer& chunk_data, int level, std::vector<u8>& blob) {
+        CompressionType type = level == 0 ? CompressionType::NONE : CompressionType::ZLIB;
+        if (type == CompressionType::NONE) {
+            blob.resize(CHUNK_HEADER_SIZE + chunk_data.size());
+            std::memcpy(blob.data() + CHUNK_HEADER_SIZE, chunk_data.data(), chunk_data.size());
+        } else {
+            Deflater& deflater = thread_deflater();
+            deflater.set_level(level);
+            deflater.compress(chunk_data.data(), chunk_data.size(), blob, CHUNK_HEADER_SIZE);
+        }
+        
+        size_t stored = blob.size();
+        put_be32(blob.data(), static_cast<u32>(stored - 4));
+        blob[4] = static_cast<u8>(type);
+        blob.resize(stored + CHECKSUM_TRAILER_SIZE);
+        put_be32(blob.data() + stored, crc32c(blob.data(), stored));
+        put_be32(blob.data() + stored + 4, CHECKSUM_MAGIC);
+        
+        raw_chunk_bytes_.fetch_add(chunk_data.size(), std::memory_order_relaxed);
+        stored_chunk_bytes_.fetch_add(blob.size(), std::memory_order_relaxed);
+    }
+    
+    Buffer decode_chunk_blob(const u8* blob, size_t blob_size, std::vector<u8>& payload) {
+        if (blob_size < CHUNK_HEADER_SIZE) {
+            throw std::runtime_error("Chunk blob too short");
+        }
+        u32 length = get_be32(blob);
+        if (length < 1 || length > blob_size - 4) {
+            throw std::runtime_error("Invalid chunk length " + std::to_string(length));
+        }
+        const u8* data = blob + CHUNK_HEADER_SIZE;
+        size_t size = length - 1;
+        
+        // Chunks written by other Anvil tools have no trailer and load unverified.
+        size_t stored = size_t(length) + 4;
+        if (blob_size - stored >= CHECKSUM_TRAILER_SIZE && get_be32(blob + stored + 4) == CHECKSUM_MAGIC &&
+            crc32c(blob, stored) != get_be32(blob + stored)) {
+            throw ChunkChecksumError("Chunk checksum mismatch");
+        }
+        
+        u8 type = blob[4];
+        if (type & EXTERNAL_CHUNK_FLAG) {
+            throw std::runtime_error("Chunk is stored in an external .mcc file, which is not supported");
+        }
+        switch (static_cast<CompressionType>(type)) {
+            case CompressionType::NONE:
+                return Buffer(data, size);
+            case CompressionType::ZLIB:
+            case CompressionType::GZIP:
+                thread_inflater().decompress(data, size, payload);
+                return Buffer(payload.data(), payload.size());
+            default:
+                throw std::runtime_error("Unsupported chunk compression " + std::to_string(type));
+        }
+    }
+    
+    RegionFile* find_region_file(i32 region_x, i32 region_z) const {
+        std::shared_lock<std::shared_mutex> lock(regions_mutex_);
+        auto it = region_files_.find(std::make_pair(region_x, region_z));
+        return it != region_files_.end() ? it->second.get() : nullptr;
+    }
+    
+    bool read_mapped_chunk(const ChunkPos& chunk_pos, ChunkPtr& chunk) {
+        auto [region_x, region_z] = get_region_coords(chunk_pos);
+        auto [local_x, local_z] = get_local_chunk_coords(chunk_pos);
+        
+        EpochGuard guard;
+        RegionFile* region_file = find_region_file(region_x, region_z);
+        if (!region_file) return false;
+        const MappedRegion* mapping = region_file->mapping.load(std::memory_order_acquire);
+        if (!mapping) return false;
+        region_file->last_used.store(access_clock_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        
+        u64 sequence = region_file->write_sequence.load(std::memory_order_acquire);
+        if (sequence & 1) return false;
+        
+        u32 location = region_file->locations[local_z * 32 + local_x].load(std::memory_order_acquire);
+        u64 begin = u64(SectorAllocator::offset_of(location)) * SectorAllocator::SECTOR_SIZE;
+        u64 length = u64(SectorAllocator::count_of(location)) * SectorAllocator::SECTOR_SIZE;
+        
+        if (length == 0 || begin < SectorAllocator::HEADER_SECTORS * SectorAllocator::SECTOR_SIZE) {
+            chunk = nullptr;
+        } else {
+            if (begin + length > region_file->mapped_bytes.load(std::memory_order_acquire)) return false;
+            
+            mapping->prefetch(begin, length);
+            try {
+                thread_local std::vector<u8> payload;
+                Buffer buffer = decode_chunk_blob(mapping->data() + begin, length, payload);
+                chunk = deserialize_chunk(chunk_pos, buffer);
+            } catch (const std::exception&) {
+                if (region_file->write_sequence.load(std::memory_order_acquire) != sequence) return false;
+                throw;
+            }
+        }
+        
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return region_file->write_sequence.load(std::memory_order_relaxed) == sequence;
+    }
+    
+    void write_sectors(RegionFile& region_file, u32 sector_offset, const u8* data, size_t size) {
+        region_file.unsynced = true;
+        region_file.file.seekp(static_cast<std::streamoff>(sector_offset) * SectorAllocator::SECTOR_SIZE);
+        region_file.file.write(reinterpret_cast<const char*>(data), size);
+        
+        size_t padding = (SectorAllocator::SECTOR_SIZE - (size % SectorAllocator::SECTOR_SIZE)) % SectorAllocator::SECTOR_SIZE;
+        if (padding > 0) {
+            std::vector<char> padding_data(padding, 0);
+            region_file.file.write(padding_data.data(), padding);
+        }
+        
+        if (!region_file.file) {
+            region_file.file.clear();
+            throw std::runtime_error("Failed to write region file " + region_file.path);
+        }
+    }
+    
+    void move_chunk(RegionFile& region_file, i32 index, u32 target, std::vector<u8>& blob) {
+        u32 location = region_file.locations[index].load(std::memory_order_relaxed);
+        u32 count = SectorAllocator::count_of(location);
+        blob.resize(static_cast<size_t>(count) * SectorAllocator::SECTOR_SIZE);
+        region_file.file.seekg(static_cast<std::streamoff>(SectorAllocator::offset_of(location)) * SectorAllocator::SECTOR_SIZE);
+        region_file.file.read(reinterpret_cast<char*>(blob.data()), blob.size());
+        if (!region_file.file) {
+            region_file.file.clear();
+            throw std::runtime_error("Failed to read region file " + region_file.path);
         }
         
+        region_file.sectors.claim(target, count);
+        write_sectors(region_file, target, blob.data(), blob.size());
+        region_file.locations[index].store(SectorAllocator::make_location(target, count), std::memory_order_release);
+        region_file.pending_release.push_back(location);
+        commit_region_header(region_file);
+    }
+    
+    // Slides every chunk down to the lowest free sector, in offset order, so the file ends up with
+    // no free sectors at all. A chunk whose target overlaps its own sectors is first parked in a
+    // free run elsewhere, so each move always has an intact copy committed in the header.
+    u64 move_chunks_down(RegionFile& region_file) {
+        std::vector<std::pair<u32, i32>> by_offset;
         for (i32 i = 0; i < 1024; ++i) {
-            u32 timestamp = htobe32(region_file.timestamps[i]);
-            region_file.file.write(reinterpret_cast<const char*>(&timestamp), sizeof(u32));
+            u32 location = region_file.locations[i].load(std::memory_order_relaxed);
+            if (SectorAllocator::count_of(location) > 0) {
+                by_offset.emplace_back(SectorAllocator::offset_of(location), i);
+            }
+        }
+        std::sort(by_offset.begin(), by_offset.end());
+        
+        u64 moved_bytes = 0;
+        u32 next = SectorAllocator::HEADER_SECTORS;
+        std::vector<u8> blob;
+        for (const auto& [offset, index] : by_offset) {
+            u32 count = SectorAllocator::count_of(region_file.locations[index].load(std::memory_order_relaxed));
+            if (offset > next) {
+                if (next + count > offset) {
+                    move_chunk(region_file, index, region_file.sectors.allocate(count), blob);
+                    moved_bytes += blob.size();
+                }
+                move_chunk(region_file, index, next, blob);
+                moved_bytes += blob.size();
+            }
+            next += count;
+        }
+        return moved_bytes;
+    }
+    
+    u64 compact_region(RegionFile& region_file) {
+        u64 moved_bytes = 0;
+        {
+            RegionWrite write(region_file);
+            moved_bytes = move_chunks_down(region_file);
+            region_file.sectors.shrink_to_fit();
         }
         
+        u32 end = region_file.sectors.file_sectors();
         region_file.file.flush();
+        g_epoch_manager.synchronize();
+        std::filesystem::resize_file(region_file.path, static_cast<u64>(end) * SectorAllocator::SECTOR_SIZE);
+        return moved_bytes;
+    }
+    
+    // A chunk that fails its checksum is copied, as [x][z][location][sectors], to the region's
+    // .corrupt file, once per stored location. The regenerated stand-in is marked saved, so it
+    // only replaces the stored blob once it is edited.
+    ChunkPtr recover_corrupt_chunk(const ChunkPos& chunk_pos) {
+        auto [region_x, region_z] = get_region_coords(chunk_pos);
+        auto [local_x, local_z] = get_local_chunk_coords(chunk_pos);
+        RegionFilePtr region_file = get_region_file(region_x, region_z);
+        try {
+            std::lock_guard<std::mutex> lock(region_file->mutex);
+            u32 location = region_file->locations[local_z * 32 + local_x].load(std::memory_order_relaxed);
+            std::lock_guard<std::mutex> quarantine_lock(quarantine_mutex_);
+            auto it = quarantined_.find(chunk_pos);
+            if (location != 0 && ensure_open(*region_file) && (it == quarantined_.end() || it->second != location)) {
+                std::vector<u8> record(12 + size_t(SectorAllocator::count_of(location)) * SectorAllocator::SECTOR_SIZE);
+                put_be32(record.data(), static_cast<u32>(chunk_pos.x));
+                put_be32(record.data() + 4, static_cast<u32>(chunk_pos.z));
+                put_be32(record.data() + 8, location);
+                region_file->file.seekg(static_cast<std::streamoff>(SectorAllocator::offset_of(location)) * SectorAllocator::SECTOR_SIZE);
+                region_file->file.read(reinterpret_cast<char*>(record.data() + 12), record.size() - 12);
+                if (!region_file->file) {
+                    region_file->file.clear();
+                    throw std::runtime_error("Failed to read " + region_file->path);
+                }
+                std::ofstream out(region_file->path + ".corrupt", std::ios::binary | std::ios::app);
+                out.write(reinterpret_cast<const char*>(record.data()), record.size());
+                if (!out.flush()) {
+                    throw std::runtime_error("Failed to write " + region_file->path + ".corrupt");
+                }
+                quarantined_[chunk_pos] = location;
+                LOG_WARN("Copied corrupt chunk " + std::to_string(chunk_pos.x) + ", " + std::to_string(chunk_pos.z) +
+                         " to " + region_file->path + ".corrupt");
+            }
+        } catch (const std::exception& e) {
+            LOG_ERROR("Failed to quarantine chunk " + std::to_string(chunk_pos.x) + ", " +
+                      std::to_string(chunk_pos.z) + ": " + e.what());
+        }
+        
+        auto chunk = std::make_shared<Chunk>(chunk_pos);
+        chunk->generate_flat_world();
+        chunk->mark_saved(chunk->get_version());
+        return chunk;
     }
     
-    u32 be32toh(u32 value) const {
+    static u32 from_be32(u32 value) {
         return ((value & 0xFF000000) >> 24) |
                ((value & 0x00FF0000) >> 8) |
                ((value & 0x0000FF00) << 8) |
                ((value & 0x000000FF) << 24);
     }
     
-    u32 htobe32(u32 value) const {
-        return be32toh(value);
+    static u32 to_be32(u32 value) {
+        return from_be32(value);
     }
 
 public:
@@ -138,97 +903,293 @@ public:
         close_all_region_files();
     }
     
-    bool save_chunk(ChunkPtr chunk) {
+    bool save_chunk(ChunkPtr chunk, bool fast = false) {
         if (!chunk || !chunk->is_dirty()) {
             return true;
         }
         
-        std::lock_guard<std::mutex> lock(save_mutex_);
+        ChunkSnapshot snapshot(std::move(chunk));
+        std::vector<u8> blob;
+        if (!encode_chunk(snapshot, fast, blob)) {
+            return false;
+        }
+        if (blob.empty()) {
+            unmodified_chunks_++;
+            mark_chunk_saved(snapshot);
+            return true;
+        }
         
-        try {
-            auto [region_x, region_z] = get_region_coords(chunk->get_position());
-            auto [local_x, local_z] = get_local_chunk_coords(chunk->get_position());
-            
-            RegionFile* region_file = get_region_file(region_x, region_z);
-            if (!region_file || !region_file->file.is_open()) {
-                return false;
+        auto [region_x, region_z] = get_region_coords(snapshot.get_position());
+        RegionFilePtr region_file = get_region_file(region_x, region_z);
+        std::lock_guard<std::mutex> lock(region_file->mutex);
+        if (!write_chunk(*region_file, snapshot, blob) ||
+            (region_file->dirty && !try_commit_region_header(*region_file))) {
+            return false;
+        }
+        mark_chunk_saved(snapshot);
+        return true;
+    }
+    
+    SnapshotSaveReport save_snapshots(const std::vector<ChunkSnapshot>& snapshots, bool fast = false) {
+        SnapshotSaveReport report;
+        report.chunks = snapshots.size();
+        std::vector<std::pair<RegionFilePtr, std::vector<EncodedChunk>>> by_region;
+        
+        for (const auto& snapshot : snapshots) {
+            if (!snapshot.chunk() || snapshot.chunk()->get_saved_version() >= snapshot.get_version()) continue;
+            EncodedChunk encoded{&snapshot, {}};
+            if (!encode_chunk(snapshot, fast, encoded.blob)) continue;
+            if (encoded.blob.empty()) {
+                unmodified_chunks_++;
+                mark_chunk_saved(snapshot);
+                report.saved++;
+                continue;
             }
-            
-            Buffer chunk_data(65536);
-            serialize_chunk(chunk, chunk_data);
-            
-            i32 chunk_index = local_z * 32 + local_x;
-            u32 old_location = region_file->locations[chunk_index];
-            
-            region_file->file.seekp(0, std::ios::end);
-            u32 sector_offset = static_cast<u32>(region_file->file.tellp()) / 4096;
-            u32 sector_count = (chunk_data.size() + 4095) / 4096;
-            
-            region_file->file.write(reinterpret_cast<const char*>(chunk_data.data()), chunk_data.size());
-            
-            size_t padding = (4096 - (chunk_data.size() % 4096)) % 4096;
-            if (padding > 0) {
-                std::vector<char> padding_data(padding, 0);
-                region_file->file.write(padding_data.data(), padding);
+            auto [region_x, region_z] = get_region_coords(snapshot.get_position());
+            RegionFilePtr region_file = get_region_file(region_x, region_z);
+            auto it = std::find_if(by_region.begin(), by_region.end(),
+                                   [&](const auto& entry) { return entry.first == region_file; });
+            if (it == by_region.end()) {
+                by_region.emplace_back(region_file, std::vector<EncodedChunk>());
+                it = by_region.end() - 1;
             }
-            
-            region_file->locations[chunk_index] = (sector_offset << 8) | (sector_count & 0xFF);
-            region_file->timestamps[chunk_index] = static_cast<u32>(
-                std::chrono::system_clock::now().time_since_epoch().count() / 1000000000);
-            
-            region_file->dirty = true;
-            save_region_header(*region_file);
-            
-            chunk->set_dirty(false);
-            
-            return true;
-            
-        } catch (const std::exception& e) {
-            LOG_ERROR("Failed to save chunk " + std::to_string(chunk->get_position().x) + 
-                     ", " + std::to_string(chunk->get_position().z) + ": " + e.what());
-            return false;
+            it->second.push_back(std::move(encoded));
+        }
+        
+        for (auto& [region_file, encoded] : by_region) {
+            std::lock_guard<std::mutex> lock(region_file->mutex);
+            if (write_chunks(*region_file, encoded) == 0) continue;
+            if (region_file->dirty && !try_commit_region_header(*region_file)) continue;
+            for (const auto& chunk : encoded) {
+                if (!chunk.written) continue;
+                mark_chunk_saved(*chunk.snapshot);
+                report.bytes += chunk.blob.size();
+                report.saved++;
+            }
+        }
+        
+        for (const auto& snapshot : snapshots) {
+            if (snapshot.chunk() && snapshot.chunk()->get_saved_version() < snapshot.get_version()) report.failed++;
+        }
+        return report;
+    }
+    
+    size_t save_chunks(const std::vector<ChunkPtr>& chunks, bool fast = false) {
+        std::vector<ChunkSnapshot> snapshots;
+        snapshots.reserve(chunks.size());
+        for (const auto& chunk : chunks) {
+            if (chunk && chunk->is_dirty()) snapshots.emplace_back(chunk);
         }
+        return save_snapshots(snapshots, fast).saved;
     }
     
+    // nullptr means the chunk was never stored. A checksum mismatch yields a regenerated chunk
+    // (see recover_corrupt_chunk); any other failure to load a stored chunk throws, so callers
+    // never mistake a damaged chunk for an absent one.
     ChunkPtr load_chunk(const ChunkPos& chunk_pos) {
-        std::lock_guard<std::mutex> lock(save_mutex_);
-        
         try {
+            ChunkPtr chunk;
+            if (read_mapped_chunk(chunk_pos, chunk)) {
+                mapped_reads_.fetch_add(1, std::memory_order_relaxed);
+                return chunk;
+            }
+            
             auto [region_x, region_z] = get_region_coords(chunk_pos);
             auto [local_x, local_z] = get_local_chunk_coords(chunk_pos);
             
-            RegionFile* region_file = get_region_file(region_x, region_z);
-            if (!region_file || !region_file->file.is_open()) {
-                return nullptr;
+            RegionFilePtr region_file = get_region_file(region_x, region_z);
+            std::lock_guard<std::mutex> lock(region_file->mutex);
+            locked_reads_.fetch_add(1, std::memory_order_relaxed);
+            if (!ensure_open(*region_file)) {
+                throw std::runtime_error("Failed to open " + region_file->path);
             }
             
             i32 chunk_index = local_z * 32 + local_x;
-            u32 location = region_file->locations[chunk_index];
+            u32 location = region_file->locations[chunk_index].load(std::memory_order_relaxed);
             
             if (location == 0) {
                 return nullptr;
             }
             
-            u32 sector_offset = (location >> 8) & 0xFFFFFF;
-            u32 sector_count = location & 0xFF;
+            u32 sector_offset = SectorAllocator::offset_of(location);
+            u32 sector_count = SectorAllocator::count_of(location);
             
-            if (sector_offset == 0 || sector_count == 0) {
-                return nullptr;
+            if (sector_offset < SectorAllocator::HEADER_SECTORS || sector_count == 0) {
+                throw std::runtime_error("Invalid chunk location " + std::to_string(location) + " in " + region_file->path);
             }
             
-            region_file->file.seekg(sector_offset * 4096);
+            region_file->file.seekg(static_cast<std::streamoff>(sector_offset) * SectorAllocator::SECTOR_SIZE);
             
-            std::vector<u8> chunk_data(sector_count * 4096);
+            std::vector<u8> chunk_data(static_cast<size_t>(sector_count) * SectorAllocator::SECTOR_SIZE);
             region_file->file.read(reinterpret_cast<char*>(chunk_data.data()), chunk_data.size());
+            if (!region_file->file) {
+                region_file->file.clear();
+                throw std::runtime_error("Truncated chunk data in " + region_file->path);
+            }
             
-            Buffer buffer(chunk_data.data(), chunk_data.size());
+            thread_local std::vector<u8> payload;
+            Buffer buffer = decode_chunk_blob(chunk_data.data(), chunk_data.size(), payload);
             return deserialize_chunk(chunk_pos, buffer);
             
+        } catch (const ChunkChecksumError& e) {
+            checksum_failures_.fetch_add(1, std::memory_order_relaxed);
+            LOG_ERROR("Chunk " + std::to_string(chunk_pos.x) + ", " + std::to_string(chunk_pos.z) +
+                     " failed its checksum: " + e.what());
+            return recover_corrupt_chunk(chunk_pos);
         } catch (const std::exception& e) {
             LOG_ERROR("Failed to load chunk " + std::to_string(chunk_pos.x) + 
                      ", " + std::to_string(chunk_pos.z) + ": " + e.what());
-            return nullptr;
+            throw;
+        }
+    }
+    
+    u64 compact_region_files() {
+        u64 moved_bytes = 0;
+        
+        for (const auto& region_file : get_region_files()) {
+            std::lock_guard<std::mutex> lock(region_file->mutex);
+            if (!region_file->file.is_open()) continue;
+            try {
+                if (region_file->dirty) commit_region_header(*region_file);
+                if (region_file->sectors.free_sectors() == 0) continue;
+                moved_bytes += compact_region(*region_file);
+            } catch (const std::exception& e) {
+                LOG_ERROR("Failed to compact " + region_file->path + ": " + e.what());
+            }
+        }
+        
+        compacted_bytes_ += moved_bytes;
+        return moved_bytes;
+    }
+    
+    std::vector<std::pair<i32, i32>> list_region_files() const {
+        std::vector<std::pair<i32, i32>> regions;
+        for (const auto& entry : std::filesystem::directory_iterator(region_directory_)) {
+            std::string name = entry.path().filename().string();
+            i32 region_x, region_z;
+            if (std::sscanf(name.c_str(), "r.%d.%d.mca", &region_x, &region_z) == 2 &&
+                name == get_region_filename(region_x, region_z)) {
+                regions.emplace_back(region_x, region_z);
+            }
+        }
+        return regions;
+    }
+    
+    // Decodes every chunk in the region and reports how its sectors are used. Chunks that fail
+    // to decode or overlap an earlier chunk count as corrupt; with drop_corrupt their slots are
+    // cleared so the chunk regenerates on next load.
+    RegionScanReport scan_region(i32 region_x, i32 region_z, bool compact, bool drop_corrupt = false) {
+        RegionScanReport report;
+        report.region_x = region_x;
+        report.region_z = region_z;
+        
+        RegionFilePtr region_file = get_region_file(region_x, region_z);
+        std::lock_guard<std::mutex> lock(region_file->mutex);
+        if (!ensure_open(*region_file)) {
+            throw std::runtime_error("Failed to open region file " + region_file->path);
+        }
+        if (region_file->dirty) commit_region_header(*region_file);
+        
+        u32 file_sectors = SectorAllocator::sectors_for(std::filesystem::file_size(region_file->path));
+        std::vector<bool> claimed(file_sectors, false);
+        std::vector<u8> blob;
+        std::vector<u8> payload;
+        
+        for (i32 i = 0; i < 1024; ++i) {
+            u32 location = region_file->locations[i].load(std::memory_order_relaxed);
+            if (location == 0) continue;
+            report.chunks++;
+            
+            u32 offset = SectorAllocator::offset_of(location);
+            u32 count = SectorAllocator::count_of(location);
+            bool valid = offset >= SectorAllocator::HEADER_SECTORS && count > 0 && offset + count <= file_sectors;
+            for (u32 sector = offset; valid && sector < offset + count; ++sector) {
+                valid = !claimed[sector];
+            }
+            
+            if (valid) {
+                std::fill(claimed.begin() + offset, claimed.begin() + offset + count, true);
+                try {
+                    blob.resize(static_cast<size_t>(count) * SectorAllocator::SECTOR_SIZE);
+                    region_file->file.seekg(static_cast<std::streamoff>(offset) * SectorAllocator::SECTOR_SIZE);
+                    region_file->file.read(reinterpret_cast<char*>(blob.data()), blob.size());
+                    if (!region_file->file) {
+                        region_file->file.clear();
+                        throw std::runtime_error("Truncated chunk data");
+                    }
+                    Buffer buffer = decode_chunk_blob(blob.data(), blob.size(), payload);
+                    deserialize_chunk(ChunkPos(region_x * 32 + i % 32, region_z * 32 + i / 32), buffer);
+                    report.payload_bytes += u64(get_be32(blob.data())) + 4;
+                    report.used_bytes += blob.size();
+                } catch (const std::exception& e) {
+                    report.errors.push_back("chunk " + std::to_string(i % 32) + ", " + std::to_string(i / 32) + ": " + e.what());
+                    valid = false;
+                }
+            } else {
+                report.errors.push_back("chunk " + std::to_string(i % 32) + ", " + std::to_string(i / 32) +
+                                        ": bad location " + std::to_string(offset) + "+" + std::to_string(count));
+            }
+            
+            if (!valid) {
+                report.corrupt_chunks++;
+                if (drop_corrupt) {
+                    region_file->locations[i].store(0, std::memory_order_release);
+                    region_file->timestamps[i] = 0;
+                    region_file->dirty = true;
+                    report.dropped_chunks++;
+                }
+            }
+        }
+        
+        if (report.dropped_chunks > 0) {
+            RegionWrite write(*region_file);
+            region_file->sectors.rebuild(region_file->locations, file_sectors);
+            commit_region_header(*region_file);
+        }
+        
+        report.file_bytes = u64(file_sectors) * SectorAllocator::SECTOR_SIZE;
+        report.free_bytes = u64(region_file->sectors.free_sectors()) * SectorAllocator::SECTOR_SIZE;
+        report.free_runs = region_file->sectors.free_runs();
+        
+        report.compacted_file_bytes = report.file_bytes;
+        if (compact && (region_file->sectors.free_sectors() > 0 || region_file->sectors.file_sectors() < file_sectors)) {
+            report.moved_bytes = compact_region(*region_file);
+            report.compacted_file_bytes = u64(region_file->sectors.file_sectors()) * SectorAllocator::SECTOR_SIZE;
+            compacted_bytes_ += report.moved_bytes;
+        }
+        return report;
+    }
+    
+    RegionStorageStats get_storage_stats() const {
+        RegionStorageStats stats;
+        
+        for (const auto& region_file : get_region_files()) {
+            std::lock_guard<std::mutex> lock(region_file->mutex);
+            if (!region_file->header_loaded) continue;
+            const auto& sectors = region_file->sectors;
+            stats.region_files++;
+            stats.file_bytes += u64(sectors.file_sectors()) * SectorAllocator::SECTOR_SIZE;
+            stats.used_bytes += u64(sectors.used_sectors() - SectorAllocator::HEADER_SECTORS) * SectorAllocator::SECTOR_SIZE;
+            stats.free_bytes += u64(sectors.free_sectors()) * SectorAllocator::SECTOR_SIZE;
+            stats.free_runs += sectors.free_runs();
         }
+        
+        stats.bytes_grown = bytes_grown_.load(std::memory_order_relaxed);
+        stats.raw_chunk_bytes = raw_chunk_bytes_.load(std::memory_order_relaxed);
+        stats.stored_chunk_bytes = stored_chunk_bytes_.load(std::memory_order_relaxed);
+        stats.in_place_writes = in_place_writes_.load(std::memory_order_relaxed);
+        stats.relocated_writes = relocated_writes_.load(std::memory_order_relaxed);
+        stats.compacted_bytes = compacted_bytes_.load(std::memory_order_relaxed);
+        stats.mapped_reads = mapped_reads_.load(std::memory_order_relaxed);
+        stats.locked_reads = locked_reads_.load(std::memory_order_relaxed);
+        stats.header_writes = header_writes_.load(std::memory_order_relaxed);
+        stats.synced_commits = synced_commits_.load(std::memory_order_relaxed);
+        stats.uring_writes = uring_writes_.load(std::memory_order_relaxed);
+        stats.uring_submits = uring_submits_.load(std::memory_order_relaxed);
+        stats.unmodified_chunks = unmodified_chunks_.load(std::memory_order_relaxed);
+        stats.delta_chunks = delta_chunks_.load(std::memory_order_relaxed);
+        stats.checksum_failures = checksum_failures_.load(std::memory_order_relaxed);
+        return stats;
     }
     
     std::future<bool> save_chunk_async(ChunkPtr chunk) {
@@ -237,6 +1198,157 @@ public:
         });
     }
     
+    void save_snapshots_async(std::vector<ChunkSnapshot> snapshots, SnapshotSaveCallback on_complete = nullptr) {
+        struct Batch {
+            std::atomic<size_t> remaining{0};
+            std::atomic<size_t> saved{0};
+            std::atomic<size_t> failed{0};
+            std::atomic<u64> bytes{0};
+            size_t chunks = 0;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            SnapshotSaveCallback on_complete;
+        };
+        
+        std::unordered_map<std::pair<i32, i32>, std::vector<ChunkSnapshot>, PairHash<i32, i32>> by_region;
+        for (auto& snapshot : snapshots) {
+            if (snapshot.chunk()) by_region[get_region_coords(snapshot.get_position())].push_back(std::move(snapshot));
+        }
+        
+        auto batch = std::make_shared<Batch>();
+        batch->chunks = snapshots.size();
+        batch->on_complete = std::move(on_complete);
+        batch->remaining.store(by_region.size());
+        
+        if (by_region.empty()) {
+            if (batch->on_complete) batch->on_complete(SnapshotSaveReport{});
+            return;
+        }
+        
+        for (auto& [region, region_snapshots] : by_region) {
+            g_thread_pool.submit([this, batch, region_snapshots = std::move(region_snapshots)]() {
+                SnapshotSaveReport report = save_snapshots(region_snapshots);
+                batch->saved.fetch_add(report.saved);
+                batch->failed.fetch_add(report.failed);
+                batch->bytes.fetch_add(report.bytes);
+                if (batch->remaining.fetch_sub(1) == 1 && batch->on_complete) {
+                    SnapshotSaveReport total;
+                    total.chunks = batch->chunks;
+                    total.saved = batch->saved.load();
+                    total.failed = batch->failed.load();
+                    total.bytes = batch->bytes.load();
+                    total.duration_ms = std::chrono::duration<f64, std::milli>(
+                        std::chrono::steady_clock::now() - batch->start).count();
+                    batch->on_complete(total);
+                }
+            });
+        }
+    }
+    
+    void save_chunks_async(const std::vector<ChunkPtr>& chunks, SnapshotSaveCallback on_complete = nullptr) {
+        std::vector<ChunkSnapshot> snapshots;
+        snapshots.reserve(chunks.size());
+        for (const auto& chunk : chunks) {
+            if (chunk && chunk->is_dirty()) snapshots.emplace_back(chunk);
+        }
+        save_snapshots_async(std::move(snapshots), std::move(on_complete));
+    }
+    
+    ChunkPtr read_chunk(const ChunkPos& chunk_pos) override {
+        return load_chunk(chunk_pos);
+    }
+    
+    void save_chunk_in_background(ChunkPtr chunk, std::function<void()> on_done = nullptr) override {
+        bool fast = fast_background_saves_.load();
+        pending_background_saves_.fetch_add(1);
+        g_thread_pool.submit([this, chunk = std::move(chunk), fast, on_done = std::move(on_done)]() {
+            bool saved = save_chunk(chunk, fast);
+            if (!saved) {
+                std::lock_guard<std::mutex> lock(failed_saves_mutex_);
+                if (chunk->is_dirty()) failed_saves_[chunk->get_position()] = chunk->get_version();
+            }
+            if (on_done) on_done();
+            pending_background_saves_.fetch_sub(1);
+            return saved;
+        });
+    }
+    
+    // Forces every region written since its last sync to stable storage, whatever sync_writes
+    // says; the block log calls this before deleting the segments those writes replace.
+    bool sync_region_files() {
+        bool synced = true;
+        for (const auto& region_file : get_region_files()) {
+            std::lock_guard<std::mutex> lock(region_file->mutex);
+            if (!region_file->unsynced) continue;
+            try {
+                sync_region_data(*region_file, true);
+            } catch (const std::exception& e) {
+                LOG_ERROR(std::string("Failed to sync region data: ") + e.what());
+                synced = false;
+            }
+        }
+        return synced;
+    }
+    
+    // Evicted chunks are only durable once their background save lands. A failed one stays dirty
+    // in the chunk manager, so the next checkpoint that saves it settles it again.
+    bool background_saves_settled() const {
+        std::lock_guard<std::mutex> lock(failed_saves_mutex_);
+        return pending_background_saves_.load() == 0 && failed_saves_.empty();
+    }
+    
+    size_t get_failed_save_count() const {
+        std::lock_guard<std::mutex> lock(failed_saves_mutex_);
+        return failed_saves_.size();
+    }
+    
+    const std::string& get_world_directory() const {
+        return world_directory_;
+    }
+    
+    void set_compression_level(int level) {
+        compression_level_.store(std::clamp(level, 0, 9));
+    }
+    
+    int get_compression_level() const {
+        return compression_level_.load();
+    }
+    
+    void set_fast_background_saves(bool enabled) {
+        fast_background_saves_.store(enabled);
+    }
+    
+    void set_sync_writes(bool enabled) {
+        sync_writes_.store(enabled);
+    }
+    
+    void set_io_uring(bool enabled) {
+        use_io_uring_.store(enabled);
+    }
+    
+    void set_generator_deltas(bool enabled) {
+        generator_deltas_.store(enabled);
+    }
+    
+    void set_max_open_regions(size_t count) {
+        max_open_regions_.store(std::max<size_t>(count, 1));
+        evict_region_handles();
+    }
+    
+    u64 get_checksum_failures() const {
+        return checksum_failures_.load(std::memory_order_relaxed);
+    }
+    
+    RegionCacheStats get_region_cache_stats() const {
+        RegionCacheStats stats;
+        stats.hits = region_cache_hits_.load(std::memory_order_relaxed);
+        stats.misses = region_cache_misses_.load(std::memory_order_relaxed);
+        stats.evictions = region_evictions_.load(std::memory_order_relaxed);
+        stats.open_handles = open_handles_.load(std::memory_order_relaxed);
+        std::shared_lock<std::shared_mutex> lock(regions_mutex_);
+        stats.cached_headers = region_files_.size();
+        return stats;
+    }
+    
     std::future<ChunkPtr> load_chunk_async(const ChunkPos& chunk_pos) {
         return g_thread_pool.submit([this, chunk_pos]() {
             return load_chunk(chunk_pos);
@@ -246,63 +1358,104 @@ public:
     void save_all_chunks() {
         LOG_INFO("Saving all loaded chunks...");
         
-        auto loaded_chunks = g_chunk_manager.get_loaded_chunk_count();
-        size_t saved_count = 0;
-        
-        for (const auto& [pos, region_file] : region_files_) {
-            if (region_file->dirty) {
-                save_region_header(*region_file);
-                region_file->dirty = false;
-                saved_count++;
-            }
-        }
+        size_t saved_count = commit_region_headers(get_region_files());
         
         LOG_INFO("Saved " + std::to_string(saved_count) + " region files");
     }
     
     void close_all_region_files() {
-        std::lock_guard<std::mutex> lock(save_mutex_);
+        decltype(region_files_) closing;
+        {
+            std::unique_lock<std::shared_mutex> regions_lock(regions_mutex_);
+            closing.swap(region_files_);
+        }
+        g_epoch_manager.synchronize();
         
-        for (auto& [pos, region_file] : region_files_) {
+        for (auto& [pos, region_file] : closing) {
+            std::lock_guard<std::mutex> lock(region_file->mutex);
             if (region_file->file.is_open()) {
                 if (region_file->dirty) {
-                    save_region_header(*region_file);
+                    try_commit_region_header(*region_file);
                 }
-                region_file->file.close();
+                close_region_handle(*region_file);
             }
         }
-        
-        region_files_.clear();
     }
 
 private:
-    void serialize_chunk(ChunkPtr chunk, Buffer& buffer) {
-        auto sections = chunk->get_sections();
+    static constexpr u8 SECTION_ABSENT = 0;
+    static constexpr u8 SECTION_UNIFORM = 1;
+    static constexpr u8 SECTION_PALETTED = 2;
+    static constexpr i32 GENERATOR_DELTA = -1;
+    static constexpr u8 GENERATOR_FLAT = 1;
+
+    void serialize_chunk(const ChunkSnapshot& chunk, Buffer& buffer, bool deltas) {
+        const auto& sections = chunk.get_sections();
+        u32 modified = chunk.get_modified_sections();
         
-        buffer.write_be<i32>(static_cast<i32>(sections.size()));
+        if (deltas && modified != Chunk::ALL_SECTIONS) {
+            buffer.write_be<i32>(GENERATOR_DELTA);
+            buffer.write_byte(GENERATOR_FLAT);
+            buffer.write_be<u32>(modified);
+            for (i32 i = 0; i < SECTIONS_PER_CHUNK; ++i) {
+                if (modified & (u32(1) << i)) serialize_section(sections[i], buffer);
+            }
+            delta_chunks_++;
+            return;
+        }
         
+        buffer.write_be<i32>(static_cast<i32>(sections.size()));
         for (const auto* section : sections) {
-            if (!section) {
-                buffer.write_byte(0);
-                continue;
-            }
-            
-            buffer.write_byte(1);
-            buffer.write_be<i16>(section->block_count);
-            
-            constexpr size_t blocks_per_section = 16 * 16 * 16;
-            for (size_t i = 0; i < blocks_per_section; ++i) {
-                i32 y = (i / 256) % 16;
-                i32 z = (i / 16) % 16;
-                i32 x = i % 16;
-                
-                auto block = section->get_block(x, y, z);
-                buffer.write_be<u16>(block.id);
-            }
-            
-            buffer.write(section->block_light, sizeof(section->block_light));
-            buffer.write(section->sky_light, sizeof(section->sky_light));
+            serialize_section(section, buffer);
+        }
+    }
+    
+    void serialize_section(const ChunkSection* section, Buffer& buffer) {
+        if (!section) {
+            buffer.write_byte(SECTION_ABSENT);
+            return;
+        }
+        
+        if (section->is_uniform()) {
+            buffer.write_byte(SECTION_UNIFORM);
+            buffer.write_be<u16>(section->get_uniform_block().id);
+            buffer.write_byte(section->block_light.uniform_value());
+            buffer.write_byte(section->sky_light.uniform_value());
+            return;
+        }
+        
+        buffer.write_byte(SECTION_PALETTED);
+        buffer.write_be<i16>(section->block_count.load(std::memory_order_relaxed));
+        serialize_blocks(section->blocks, buffer);
+        serialize_light(section->block_light, buffer);
+        serialize_light(section->sky_light, buffer);
+    }
+    
+    void serialize_blocks(const PalettedContainer& blocks, Buffer& buffer) {
+        auto snapshot = blocks.snapshot();
+        buffer.write_byte(snapshot.bits);
+        
+        buffer.write_varint(static_cast<i32>(snapshot.palette.size()));
+        for (BlockId id : snapshot.palette) {
+            buffer.write_be<u16>(id);
+        }
+        
+        buffer.write_varint(static_cast<i32>(snapshot.data.size()));
+        for (u64 word : snapshot.data) {
+            buffer.write_be<u64>(word);
+        }
+    }
+    
+    void serialize_light(const NibbleArray& light, Buffer& buffer) {
+        if (light.is_uniform()) {
+            buffer.write_byte(0);
+            buffer.write_byte(light.uniform_value());
+            return;
         }
+        u8 bytes[NibbleArray::BYTE_SIZE];
+        light.copy_to(bytes);
+        buffer.write_byte(1);
+        buffer.write(bytes, sizeof(bytes));
     }
     
     ChunkPtr deserialize_chunk(const ChunkPos& chunk_pos, Buffer& buffer) {
@@ -310,27 +1463,20 @@ private:
         
         i32 section_count = buffer.read_be<i32>();
         
-        for (i32 s = 0; s < section_count; ++s) {
-            u8 has_section = buffer.read_byte();
-            if (!has_section) continue;
-            
-            i16 block_count = buffer.read_be<i16>();
-            
-            auto section = std::make_unique<ChunkSection>();
-            section->block_count = block_count;
-            
-            constexpr size_t blocks_per_section = 16 * 16 * 16;
-            for (size_t i = 0; i < blocks_per_section; ++i) {
-                i32 y = (i / 256) % 16;
-                i32 z = (i / 16) % 16;
-                i32 x = i % 16;
-                
-                u16 block_id = buffer.read_be<u16>();
-                section->set_block(x, y, z, Block(block_id));
+        if (section_count == GENERATOR_DELTA) {
+            u8 generator = buffer.read_byte();
+            if (generator != GENERATOR_FLAT) {
+                throw std::runtime_error("Unknown generator " + std::to_string(generator));
+            }
+            chunk->generate_flat_world();
+            u32 modified = buffer.read_be<u32>();
+            for (i32 s = 0; s < SECTIONS_PER_CHUNK; ++s) {
+                if (modified & (u32(1) << s)) chunk->set_section(s, deserialize_section(buffer));
+            }
+        } else {
+            for (i32 s = 0; s < section_count; ++s) {
+                if (auto section = deserialize_section(buffer)) chunk->set_section(s, std::move(section));
             }
-            
-            buffer.read(section->block_light, sizeof(section->block_light));
-            buffer.read(section->sky_light, sizeof(section->sky_light));
         }
         
         chunk->set_loaded(true);
@@ -338,6 +1484,64 @@ private:
         
         return chunk;
     }
+    
+    std::unique_ptr<ChunkSection> deserialize_section(Buffer& buffer) {
+        u8 tag = buffer.read_byte();
+        if (tag == SECTION_ABSENT) return nullptr;
+        
+        std::unique_ptr<ChunkSection> section;
+        if (tag == SECTION_UNIFORM) {
+            BlockId block_id = buffer.read_be<u16>();
+            u8 block_light = buffer.read_byte();
+            u8 sky_light = buffer.read_byte();
+            section = std::make_unique<ChunkSection>(Block(block_id), block_light, sky_light);
+        } else if (tag == SECTION_PALETTED) {
+            section = std::make_unique<ChunkSection>();
+            section->block_count.store(buffer.read_be<i16>(), std::memory_order_relaxed);
+            deserialize_blocks(section->blocks, buffer);
+            deserialize_light(section->block_light, buffer);
+            deserialize_light(section->sky_light, buffer);
+        } else {
+            throw std::runtime_error("Unknown section tag " + std::to_string(tag));
+        }
+        return section;
+    }
+    
+    void deserialize_blocks(PalettedContainer& blocks, Buffer& buffer) {
+        u8 bits = buffer.read_byte();
+        
+        i32 palette_size = buffer.read_varint();
+        if (palette_size < 0 || palette_size > (1 << PalettedContainer::MAX_INDIRECT_BITS)) {
+            throw std::runtime_error("Invalid palette size");
+        }
+        std::vector<BlockId> palette(static_cast<size_t>(palette_size));
+        for (auto& id : palette) {
+            id = buffer.read_be<u16>();
+        }
+        
+        i32 word_count = buffer.read_varint();
+        if (word_count < 0 || word_count > PalettedContainer::ENTRY_COUNT) {
+            throw std::runtime_error("Invalid block data length");
+        }
+        std::vector<u64> data(static_cast<size_t>(word_count));
+        for (auto& word : data) {
+            word = buffer.read_be<u64>();
+        }
+        
+        blocks.assign(bits, std::move(palette), std::move(data));
+    }
+    
+    void deserialize_light(NibbleArray& light, Buffer& buffer) {
+        if (buffer.read_byte() == 0) {
+            light.fill(buffer.read_byte());
+            return;
+        }
+        u8 bytes[NibbleArray::BYTE_SIZE];
+        if (buffer.read(bytes, sizeof(bytes)) != sizeof(bytes)) {
+            throw std::runtime_error("Buffer underflow");
+        }
+        light.assign(bytes);
+    }
 };
 
 extern WorldPersistence g_world_persistence;
@@ -2,12 +2,16 @@
 #include "../src/core/memory_pool.hpp"
 #include "../src/core/thread_pool.hpp"
 #include "../src/world/chunk.hpp"
+#include "../src/world/world_persistence.hpp"
 #include "../src/network/packet_types.hpp"
+#include "../src/network/protocol_cipher.hpp"
 #include <chrono>
+#include <filesystem>
 #include <iostream>
 #include <vector>
 #include <random>
 #include <future>
+#include <thread>
 
 using namespace mc;
 
@@ -39,6 +43,7 @@ public:
         test_buffer_performance();
         test_memory_pool_performance();
         test_chunk_operations();
+        test_section_storage();
         test_packet_serialization();
         test_threading_performance();
         
@@ -120,8 +125,67 @@ private:
             }
         });
         
+        double per_block_fill_time = measure_time([&chunk]() {
+            for (i32 y = 0; y < 64; ++y)
+                for (i32 z = 0; z < 16; ++z)
+                    for (i32 x = 0; x < 16; ++x)
+                        chunk->set_block(x, y, z, world::Block(world::COBBLESTONE));
+            for (i32 y = 0; y < 64; ++y)
+                for (i32 z = 0; z < 16; ++z)
+                    for (i32 x = 0; x < 16; ++x)
+                        chunk->set_block(x, y, z, world::Block(world::AIR));
+        }, 10);
+        
+        double bulk_fill_time = measure_time([&chunk]() {
+            chunk->fill(0, 0, 0, 15, 63, 15, world::Block(world::COBBLESTONE));
+            chunk->fill(0, 0, 0, 15, 63, 15, world::Block(world::AIR));
+        }, 100);
+        
+        double partial_fill_time = measure_time([&chunk]() {
+            chunk->fill(3, 5, 2, 12, 40, 13, world::Block(world::COBBLESTONE));
+            chunk->fill(3, 5, 2, 12, 40, 13, world::Block(world::AIR));
+        }, 100);
+        
         std::cout << "  Chunk generation:   " << generation_time / 1000.0 << " ms/chunk" << std::endl;
         std::cout << "  Block access:       " << block_access_time << " μs/100 operations" << std::endl;
+        std::cout << "  Per-block fill:     " << per_block_fill_time << " μs/32768 blocks" << std::endl;
+        std::cout << "  Bulk fill:          " << bulk_fill_time << " μs/32768 blocks" << std::endl;
+        std::cout << "  Partial bulk fill:  " << partial_fill_time << " μs/8640 blocks" << std::endl;
+        std::cout << std::endl;
+    }
+    
+    void test_section_storage() {
+        std::cout << "Section Storage Performance Tests:" << std::endl;
+        
+        constexpr size_t legacy_section_bytes =
+            world::ChunkSection::BLOCKS_PER_SECTION * sizeof(world::Block) +
+            world::ChunkSection::BLOCKS_PER_SECTION;
+        
+        for (int distinct : {1, 4, 64, 1024}) {
+            world::ChunkSection section;
+            for (i32 i = 0; i < world::ChunkSection::BLOCKS_PER_SECTION; ++i) {
+                section.set_block(i & 15, i >> 8, (i >> 4) & 15,
+                                  world::Block(static_cast<world::BlockId>(rng_() % distinct)));
+            }
+            
+            double get_time = measure_time([&section, this]() {
+                i32 i = static_cast<i32>(rng_() % world::ChunkSection::BLOCKS_PER_SECTION);
+                auto block = section.get_block(i & 15, i >> 8, (i >> 4) & 15);
+                (void)block;
+            }, 100000);
+            
+            double set_time = measure_time([&section, distinct, this]() {
+                i32 i = static_cast<i32>(rng_() % world::ChunkSection::BLOCKS_PER_SECTION);
+                section.set_block(i & 15, i >> 8, (i >> 4) & 15,
+                                  world::Block(static_cast<world::BlockId>(rng_() % distinct)));
+            }, 100000);
+            
+            std::cout << "  " << distinct << " block types: "
+                      << static_cast<int>(section.blocks.bits_per_entry()) << " bits/entry, "
+                      << section.memory_usage() << " bytes/section (legacy "
+                      << legacy_section_bytes << "), get "
+                      << get_time * 1000.0 << " ns, set " << set_time * 1000.0 << " ns" << std::endl;
+        }
         std::cout << std::endl;
     }
     
@@ -268,6 +332,364 @@ void run_concurrent_chunk_test() {
     std::cout << "  Throughput: " << (total_operations.load() * 1000.0) / duration.count() << " ops/second" << std::endl;
     std::cout << "  " << num_threads << " threads, " << num_chunks << " chunks" << std::endl;
     std::cout << std::endl;
+    
+    std::cout << "Concurrent Chunk Read Scaling:" << std::endl;
+    
+    const int reads_per_thread = 1000000;
+    f64 single_thread_rate = 0.0;
+    
+    for (int threads : {1, 2, 4, 8}) {
+        std::atomic<u64> checksum{0};
+        std::vector<std::thread> readers;
+        readers.reserve(threads);
+        
+        auto read_start = std::chrono::high_resolution_clock::now();
+        for (int t = 0; t < threads; ++t) {
+            readers.emplace_back([&chunks, &checksum, reads_per_thread, t]() {
+                std::mt19937 rng(static_cast<u32>(t + 1));
+                u64 local = 0;
+                for (int i = 0; i < reads_per_thread; ++i) {
+                    const auto& chunk = chunks[rng() % chunks.size()];
+                    u32 r = rng();
+                    i32 x = r & 15;
+                    i32 z = (r >> 4) & 15;
+                    i32 y = static_cast<i32>((r >> 8) % 128);
+                    local += chunk->get_block(x, y, z).id + chunk->get_sky_light(x, y, z);
+                }
+                checksum.fetch_add(local);
+            });
+        }
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        auto read_end = std::chrono::high_resolution_clock::now();
+        
+        f64 seconds = std::chrono::duration<f64>(read_end - read_start).count();
+        f64 rate = (static_cast<f64>(threads) * reads_per_thread) / seconds;
+        if (threads == 1) single_thread_rate = rate;
+        
+        std::cout << "  " << threads << " threads: " << rate / 1e6 << " M reads/second"
+                  << " (" << rate / single_thread_rate << "x, checksum " << checksum.load() << ")" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+void run_chunk_lookup_contention_test() {
+    std::cout << "Chunk Table Lookup Contention:" << std::endl;
+    
+    const i32 radius = 16;
+    const int lookups_per_thread = 500000;
+    
+    world::ChunkManager manager;
+    manager.set_max_loaded_chunks(4096);
+    for (i32 x = -radius; x < radius; ++x) {
+        for (i32 z = -radius; z < radius; ++z) {
+            manager.load_chunk(world::ChunkPos(x, z));
+        }
+    }
+    while (manager.get_pending_chunk_count() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    
+    f64 single_thread_rate = 0.0;
+    for (int threads : {1, 2, 4, 8, 16}) {
+        std::atomic<u64> hits{0};
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&manager, &hits, lookups_per_thread, radius, t]() {
+                std::mt19937 rng(static_cast<u32>(t + 1));
+                u64 local = 0;
+                for (int i = 0; i < lookups_per_thread; ++i) {
+                    world::ChunkPos pos(static_cast<i32>(rng() % (radius * 3)) - radius * 3 / 2,
+                                        static_cast<i32>(rng() % (radius * 3)) - radius * 3 / 2);
+                    if (manager.get_chunk(pos)) local++;
+                }
+                hits.fetch_add(local);
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        
+        f64 seconds = std::chrono::duration<f64>(end - start).count();
+        f64 rate = (static_cast<f64>(threads) * lookups_per_thread) / seconds;
+        if (threads == 1) single_thread_rate = rate;
+        
+        std::cout << "  " << threads << " threads: " << rate / 1e6 << " M lookups/second"
+                  << " (" << rate / single_thread_rate << "x, hit rate "
+                  << (100.0 * hits.load()) / (static_cast<f64>(threads) * lookups_per_thread) << "%)" << std::endl;
+    }
+    std::cout << "  " << manager.get_loaded_chunk_count() << " chunks across "
+              << world::ChunkTable::SHARD_COUNT << " shards" << std::endl;
+    std::cout << std::endl;
+}
+
+void run_region_compression_test() {
+    std::cout << "Region Chunk Compression:" << std::endl;
+    
+    const int chunk_count = 256;
+    std::vector<world::ChunkPtr> chunks;
+    chunks.reserve(chunk_count);
+    std::mt19937 rng(42);
+    for (int i = 0; i < chunk_count; ++i) {
+        auto chunk = std::make_shared<world::Chunk>(world::ChunkPos(i % 16, i / 16));
+        chunk->generate_flat_world();
+        for (int j = 0; j < 2000; ++j) {
+            chunk->set_block(static_cast<i32>(rng() % 16), static_cast<i32>(rng() % 128) - 64,
+                             static_cast<i32>(rng() % 16), world::Block(static_cast<world::BlockId>(1 + rng() % 64)));
+        }
+        chunks.push_back(chunk);
+    }
+    
+    struct Mode {
+        const char* name;
+        int level;
+        bool fast;
+    };
+    const Mode modes[] = {
+        {"uncompressed", 0, false},
+        {"fast", 6, true},
+        {"default", 6, false},
+        {"best", 9, false}
+    };
+    
+    auto directory = std::filesystem::temp_directory_path() / "mc_compression_benchmark";
+    for (const auto& mode : modes) {
+        std::filesystem::remove_all(directory);
+        world::RegionStorageStats stats;
+        f64 seconds = 0.0;
+        {
+            world::WorldPersistence persistence(directory.string());
+            persistence.set_compression_level(mode.level);
+            
+            auto start = std::chrono::high_resolution_clock::now();
+            for (const auto& chunk : chunks) {
+                chunk->set_dirty(true);
+                persistence.save_chunk(chunk, mode.fast);
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            seconds = std::chrono::duration<f64>(end - start).count();
+            stats = persistence.get_storage_stats();
+        }
+        
+        std::cout << "  " << mode.name << ": "
+                  << stats.stored_chunk_bytes / chunk_count << " bytes/chunk ("
+                  << 100.0 * static_cast<f64>(stats.stored_chunk_bytes) / static_cast<f64>(stats.raw_chunk_bytes)
+                  << "% of raw), " << stats.file_bytes / 1024 << " KB on disk, "
+                  << seconds * 1e6 / chunk_count << " us/save" << std::endl;
+    }
+    std::filesystem::remove_all(directory);
+    std::cout << std::endl;
+}
+
+void run_region_io_test() {
+    std::cout << "Parallel Region IO:" << std::endl;
+    
+    const int chunk_count = 1024;
+    const int region_counts[] = {1, 2, 4, 8};
+    std::mt19937 rng(42);
+    
+    auto directory = std::filesystem::temp_directory_path() / "mc_region_io_benchmark";
+    for (int regions : region_counts) {
+        std::vector<world::ChunkPtr> chunks;
+        chunks.reserve(chunk_count);
+        for (int i = 0; i < chunk_count; ++i) {
+            int region = i % regions;
+            int local = i / regions;
+            auto chunk = std::make_shared<world::Chunk>(world::ChunkPos(region * 32 + local % 32, local / 32));
+            chunk->generate_flat_world();
+            for (int j = 0; j < 500; ++j) {
+                chunk->set_block(static_cast<i32>(rng() % 16), static_cast<i32>(rng() % 128) - 64,
+                                 static_cast<i32>(rng() % 16), world::Block(static_cast<world::BlockId>(1 + rng() % 64)));
+            }
+            chunks.push_back(chunk);
+        }
+        
+        std::filesystem::remove_all(directory);
+        world::RegionStorageStats stats;
+        f64 save_seconds = 0.0;
+        f64 load_seconds = 0.0;
+        {
+            world::WorldPersistence persistence(directory.string());
+            
+            std::promise<void> saved;
+            auto start = std::chrono::high_resolution_clock::now();
+            persistence.save_chunks_async(chunks, [&saved](const world::SnapshotSaveReport&) {
+                saved.set_value();
+            });
+            saved.get_future().wait();
+            auto end = std::chrono::high_resolution_clock::now();
+            save_seconds = std::chrono::duration<f64>(end - start).count();
+            
+            std::vector<std::future<world::ChunkPtr>> loads;
+            loads.reserve(chunk_count);
+            start = std::chrono::high_resolution_clock::now();
+            for (const auto& chunk : chunks) {
+                loads.push_back(persistence.load_chunk_async(chunk->get_position()));
+            }
+            for (auto& load : loads) {
+                load.get();
+            }
+            end = std::chrono::high_resolution_clock::now();
+            load_seconds = std::chrono::duration<f64>(end - start).count();
+            stats = persistence.get_storage_stats();
+        }
+        
+        f64 megabytes = static_cast<f64>(stats.stored_chunk_bytes) / (1024.0 * 1024.0);
+        std::cout << "  " << chunk_count << " chunks over " << regions << " region(s): save "
+                  << chunk_count / save_seconds << " chunks/sec (" << megabytes / save_seconds << " MB/s), load "
+                  << chunk_count / load_seconds << " chunks/sec" << std::endl;
+    }
+    std::filesystem::remove_all(directory);
+    std::cout << std::endl;
+}
+
+void run_region_compaction_test() {
+    std::cout << "Region Compaction:" << std::endl;
+    
+    const int chunk_count = 256;
+    std::mt19937 rng(7);
+    auto directory = std::filesystem::temp_directory_path() / "mc_compaction_test";
+    std::filesystem::remove_all(directory);
+    
+    u64 before_bytes = 0;
+    u64 after_bytes = 0;
+    u64 expected_bytes = 0;
+    int mismatched = 0;
+    {
+        world::WorldPersistence persistence(directory.string());
+        persistence.set_compression_level(0);
+        
+        std::vector<world::ChunkPtr> chunks;
+        for (int round = 0; round < 3; ++round) {
+            chunks.clear();
+            for (int i = 0; i < chunk_count; ++i) {
+                auto chunk = std::make_shared<world::Chunk>(world::ChunkPos(i % 16, i / 16));
+                chunk->generate_flat_world();
+                int edits = static_cast<int>(rng() % 4) * 3000;
+                for (int j = 0; j <= edits; ++j) {
+                    chunk->set_block(static_cast<i32>(rng() % 16), static_cast<i32>(rng() % 256) - 64,
+                                     static_cast<i32>(rng() % 16), world::Block(static_cast<world::BlockId>(1 + rng() % 64)));
+                }
+                chunk->set_block(0, 300, 0, world::Block(static_cast<world::BlockId>(1 + i % 64)));
+                chunks.push_back(chunk);
+                persistence.save_chunk(chunk);
+            }
+        }
+        
+        auto region = directory / "region" / "r.0.0.mca";
+        before_bytes = std::filesystem::file_size(region);
+        persistence.compact_region_files();
+        after_bytes = std::filesystem::file_size(region);
+        
+        auto stats = persistence.get_storage_stats();
+        expected_bytes = world::SectorAllocator::HEADER_SECTORS * world::SectorAllocator::SECTOR_SIZE + stats.used_bytes;
+        for (const auto& chunk : chunks) {
+            auto stored = persistence.load_chunk(chunk->get_position());
+            if (!stored || stored->get_block(0, 300, 0).id != chunk->get_block(0, 300, 0).id) mismatched++;
+        }
+    }
+    std::filesystem::remove_all(directory);
+    
+    bool ok = after_bytes == expected_bytes && mismatched == 0;
+    std::cout << "  " << before_bytes / 1024 << " KB -> " << after_bytes / 1024 << " KB (packed size "
+              << expected_bytes / 1024 << " KB), " << mismatched << " chunks mismatched ("
+              << (ok ? "ok" : "FAILED") << ")" << std::endl;
+    std::cout << std::endl;
+}
+
+void run_chunk_write_back_test() {
+    std::cout << "Chunk Eviction Write-Back:" << std::endl;
+    
+    const int chunk_count = 300;
+    auto directory = std::filesystem::temp_directory_path() / "mc_write_back_test";
+    std::filesystem::remove_all(directory);
+    
+    int lost = 0;
+    {
+        world::WorldPersistence persistence(directory.string());
+        world::ChunkManager manager;
+        manager.set_storage(&persistence);
+        
+        for (int i = 0; i < chunk_count; ++i) {
+            world::ChunkPos pos(i % 20, i / 20);
+            world::BlockId id = static_cast<world::BlockId>(1 + i % 60);
+            auto chunk = manager.load_chunk_async(pos).get();
+            chunk->set_block(i % 16, 10, 7, world::Block(id));
+            manager.unload_chunk(pos);
+            
+            auto reloaded = manager.load_chunk_async(pos).get();
+            if (!reloaded || reloaded->get_block(i % 16, 10, 7).id != id) lost++;
+            manager.unload_chunk(pos);
+        }
+        while (manager.get_write_back_count() > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        for (int i = 0; i < chunk_count; ++i) {
+            auto stored = persistence.load_chunk(world::ChunkPos(i % 20, i / 20));
+            if (!stored || stored->get_block(i % 16, 10, 7).id != static_cast<world::BlockId>(1 + i % 60)) lost++;
+        }
+    }
+    std::filesystem::remove_all(directory);
+    
+    std::cout << "  " << chunk_count << " chunks evicted and reloaded immediately: " << lost << " edits lost ("
+              << (lost == 0 ? "ok" : "FAILED") << ")" << std::endl;
+    std::cout << std::endl;
+}
+
+void run_protocol_encryption_test() {
+    std::cout << "Protocol Encryption (AES-CFB8):" << std::endl;
+    
+    const size_t frame_bytes = 64 * 1024;
+    const size_t total_bytes = 64u << 20;
+    std::vector<u32> thread_counts = {1};
+    if (std::thread::hardware_concurrency() > 1) thread_counts.push_back(std::thread::hardware_concurrency());
+    
+    for (u32 threads : thread_counts) {
+        std::vector<f64> encrypt_seconds(threads);
+        std::vector<f64> decrypt_seconds(threads);
+        std::atomic<bool> round_trip_ok{true};
+        std::vector<std::thread> workers;
+        for (u32 t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                std::mt19937 rng(t);
+                std::vector<u8> key(network::CipherStream::KEY_SIZE);
+                for (auto& b : key) b = static_cast<u8>(rng());
+                std::vector<u8> data(frame_bytes);
+                for (auto& b : data) b = static_cast<u8>(rng());
+                std::vector<u8> original = data;
+                
+                network::CipherStream encryptor(key.data(), true);
+                network::CipherStream decryptor(key.data(), false);
+                for (size_t done = 0; done < total_bytes; done += frame_bytes) {
+                    auto start = std::chrono::high_resolution_clock::now();
+                    encryptor.update(data.data(), data.size());
+                    auto mid = std::chrono::high_resolution_clock::now();
+                    decryptor.update(data.data(), data.size());
+                    auto end = std::chrono::high_resolution_clock::now();
+                    encrypt_seconds[t] += std::chrono::duration<f64>(mid - start).count();
+                    decrypt_seconds[t] += std::chrono::duration<f64>(end - mid).count();
+                }
+                if (data != original) round_trip_ok = false;
+            });
+        }
+        for (auto& worker : workers) worker.join();
+        
+        f64 megabytes = static_cast<f64>(total_bytes) / (1024.0 * 1024.0);
+        f64 encrypt_rate = 0.0;
+        f64 decrypt_rate = 0.0;
+        for (u32 t = 0; t < threads; ++t) {
+            encrypt_rate += megabytes / encrypt_seconds[t];
+            decrypt_rate += megabytes / decrypt_seconds[t];
+        }
+        std::cout << "  " << threads << " thread(s): encrypt " << encrypt_rate / threads << " MB/s/core, decrypt "
+                  << decrypt_rate / threads << " MB/s/core, round trip " << (round_trip_ok ? "ok" : "FAILED") << std::endl;
+    }
+    std::cout << std::endl;
 }
 
 int main() {
@@ -280,6 +702,12 @@ int main() {
     
     run_memory_stress_test();
     run_concurrent_chunk_test();
+    run_chunk_lookup_contention_test();
+    run_region_compression_test();
+    run_region_io_test();
+    run_region_compaction_test();
+    run_chunk_write_back_test();
+    run_protocol_encryption_test();
     
     std::cout << "All benchmarks completed successfully!" << std::endl;
     